@@ -22,13 +22,13 @@
 // Accelerated functions for getting/setting tile types
 
 uint8_t btile_get_tile_type( uint8_t row, uint8_t col ) {
-    uint8_t pos = ( row * 32 + col ) / 4;
+    uint8_t pos = ( row << 3 ) + ( col >> 2 );
     uint8_t rot = 2 * ( col & 0x03 );
     return ( ( screen_pos_tile_type_data[ pos ] >> rot ) & 0x03 );
 }
 
 void btile_set_tile_type( uint8_t row, uint8_t col, uint8_t type ) {
-    uint8_t pos = ( row * 32 + col ) / 4;
+    uint8_t pos = ( row << 3 ) + ( col >> 2 );
     uint8_t rot = 2 * ( col & 0x03 );
     screen_pos_tile_type_data[ pos ] = ( screen_pos_tile_type_data[ pos ] & ( ~( 0x03 << rot ) ) ) | ( type << rot );
 }
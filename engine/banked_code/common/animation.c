@@ -67,3 +67,20 @@ void animation_reset_state( struct animation_data_s *anim ) {
     anim->current.sequence_counter = 0;
     anim->current.sequence_delay_counter = 0;
 }
+
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+void animation_clocks_tick( struct animation_clock_s *clocks ) {
+    for ( ; clocks->period; clocks++ ) {
+        if ( ( clocks->fired = ! --clocks->counter ) )
+            clocks->counter = clocks->period;
+    }
+}
+
+// clocks must be reset at the same time as the animations they drive
+void animation_clocks_reset( struct animation_clock_s *clocks ) {
+    for ( ; clocks->period; clocks++ ) {
+        clocks->counter = clocks->period;
+        clocks->fired = 0;
+    }
+}
+#endif
@@ -27,8 +27,17 @@ void init_beeper( void ) {
 #endif
 
 void beeper_request_fx( void *sfx ) {
+#ifdef BUILD_FEATURE_BEEPER_ISR_FX
+    // queue the request for the interrupt driven player, drop it if the queue is full
+    uint8_t next = ( game_state.beeper_fx_queue_head + 1 ) & ( BEEPER_FX_QUEUE_SIZE - 1 );
+    if ( next != game_state.beeper_fx_queue_tail ) {
+        game_state.beeper_fx_queue[ game_state.beeper_fx_queue_head ] = sfx;
+        game_state.beeper_fx_queue_head = next;
+    }
+#else
     game_state.beeper_fx = sfx;
     SET_LOOP_FLAG( F_LOOP_PLAY_BEEPER_FX );
+#endif
 }
 
 void beeper_play_pending_fx( void ) {
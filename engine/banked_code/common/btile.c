@@ -22,3 +22,34 @@
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
 
 #endif // BUILD_FEATURE_ANIMATED_BTILES
+
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+
+// Obstacle bitmap span queries: they test a whole bitmap byte (8 columns)
+// at once.  They are only used by the hero movement code, so they are
+// built with it: in lowmem in 48K mode and in the banked code in 128K mode
+uint8_t btile_obstacle_in_row_span( uint8_t row, uint8_t c1, uint8_t c2 ) {
+    uint8_t *p = &screen_obstacle_bitmap[ ( row << 2 ) + ( c1 >> 3 ) ];
+    uint8_t *last = &screen_obstacle_bitmap[ ( row << 2 ) + ( c2 >> 3 ) ];
+    uint8_t mask = obstacle_bitmap_first_mask[ c1 & 0x07 ];
+    while ( p != last ) {
+        if ( *p++ & mask )
+            return 1;
+        mask = 0xFF;
+    }
+    return ( *p & mask & obstacle_bitmap_last_mask[ c2 & 0x07 ] );
+}
+
+uint8_t btile_obstacle_in_col_span( uint8_t col, uint8_t r1, uint8_t r2 ) {
+    uint8_t *p = &screen_obstacle_bitmap[ ( r1 << 2 ) + ( col >> 3 ) ];
+    uint8_t bit = obstacle_bitmap_bit[ col & 0x07 ];
+    uint8_t n = r2 - r1 + 1;
+    while ( n-- ) {
+        if ( *p & bit )
+            return 1;
+        p += 4;
+    }
+    return 0;
+}
+
+#endif // BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
@@ -65,17 +65,17 @@ void bullet_animate_and_move_all(void) {
         // check for obstacles
         if (
                 // moving right:
-                ( ( bs->dx > 0 ) && ( ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer ), 			PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width ) ) == TT_OBSTACLE ) ||
-                                      ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height - 1 ),	PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width ) ) == TT_OBSTACLE ) ) ) ||
+                ( ( bs->dx > 0 ) && ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer ), 			PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width ) ) ||
+                                      IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height - 1 ),	PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width ) ) ) ) ||
                 // moving left:
-                ( ( bs->dx < 0 ) && ( ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer - 1 ) ) == TT_OBSTACLE ) ||
-                                      ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height - 1 ),	PIXEL_TO_CELL_COORD( bs->position.x.part.integer - 1 ) ) == TT_OBSTACLE ) ) ) ||
+                ( ( bs->dx < 0 ) && ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer - 1 ) ) ||
+                                      IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height - 1 ),	PIXEL_TO_CELL_COORD( bs->position.x.part.integer - 1 ) ) ) ) ||
                 // moving down:
-                ( ( bs->dy > 0 ) && ( ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height ),		PIXEL_TO_CELL_COORD( bs->position.x.part.integer ) ) == TT_OBSTACLE ) ||
-                                      ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height ),		PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width - 1 ) ) == TT_OBSTACLE ) ) ) ||
+                ( ( bs->dy > 0 ) && ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height ),		PIXEL_TO_CELL_COORD( bs->position.x.part.integer ) ) ||
+                                      IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer + bi->height ),		PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width - 1 ) ) ) ) ||
                 // moving up:
-                ( ( bs->dy < 0 ) && ( ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer - 1 ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer ) ) == TT_OBSTACLE ) ||
-                                      ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer - 1 ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width - 1 ) ) == TT_OBSTACLE ) ) )
+                ( ( bs->dy < 0 ) && ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer - 1 ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer ) ) ||
+                                      IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( bs->position.y.part.integer - 1 ),			PIXEL_TO_CELL_COORD( bs->position.x.part.integer + bi->width - 1 ) ) ) )
             ) { // then
             // move bullet offscreen and deactivate
             SET_BULLET_FLAG( *bs, F_BULLET_MOVE_OFFSCREEN );
@@ -30,11 +30,33 @@ void enemy_animate_and_move( uint8_t num_enemies, struct enemy_info_s *enemies )
     static struct enemy_movement_data_s *move;
     static struct sprite_graphic_data_s *g;
     uint8_t n;
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    uint8_t i;
+#endif
+#ifdef BUILD_FEATURE_ENEMY_MOVE_HALF_SETS
+    // enemies with odd and even indexes are moved on alternate calls
+    static uint8_t half_set;
+    half_set ^= 1;
+#endif
 
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+    animation_clocks_tick( enemy_animation_clocks );
+#endif
+
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    i = game_state.num_active_enemies;
+    while( i-- ) {
+        n = game_state.active_enemies[ i ];
+#else
     n = num_enemies;
     while( n-- ) {
         if ( ! IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) )	// skip if not active
             continue;
+#endif
+#ifdef BUILD_FEATURE_ENEMY_MOVE_HALF_SETS
+        if ( ( n & 1 ) != half_set )
+            continue;
+#endif
 
         g = dataset_get_banked_sprite_ptr( enemies[n].num_graphic );
         anim = &enemies[n].animation;
@@ -47,6 +69,10 @@ void enemy_animate_and_move( uint8_t num_enemies, struct enemy_info_s *enemies )
 
         // optimization: only animate if the sprite has frames > 1; quickly skip if not
         if ( g->frame_data.num_frames > 1 )
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+            // and only if its animation clock has fired in this frame
+            if ( ANIMATION_CLOCK_FIRED( enemy_animation_clocks, anim ) )
+#endif
             // animation_sequence_tick returns tryu if the frame has changed, 0 otherwise
             // so only update the sprite if frame has changed
             if ( animation_sequence_tick( anim, g->sequence_data.sequences[ anim->current.sequence ].num_frames ) )
@@ -70,10 +96,10 @@ void enemy_animate_and_move( uint8_t num_enemies, struct enemy_info_s *enemies )
                                     ( pos->x.part.integer >= move->data.linear.xmax ) ||
                                     ( pos->x.part.integer <= move->data.linear.xmin ) ||
                                     ( ENEMY_MOVE_MUST_BOUNCE( *move ) && (
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer ), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width ) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer ), PIXEL_TO_CELL_COORD( pos->x.part.integer - 1 ) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width ) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer - 1 ) ) == TT_OBSTACLE )
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer ), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width ) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer ), PIXEL_TO_CELL_COORD( pos->x.part.integer - 1 ) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width ) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer - 1 ) )
                                     ) )
                                 ) { // then
                                 move->data.linear.dx = -move->data.linear.dx;
@@ -98,10 +124,10 @@ void enemy_animate_and_move( uint8_t num_enemies, struct enemy_info_s *enemies )
                                     ( pos->y.part.integer >= move->data.linear.ymax ) ||
                                     ( pos->y.part.integer <= move->data.linear.ymin ) ||
                                     ( ENEMY_MOVE_MUST_BOUNCE( *move ) && (
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height ), PIXEL_TO_CELL_COORD( pos->x.part.integer ) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer - 1 ), PIXEL_TO_CELL_COORD( pos->x.part.integer ) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height ), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width - 1) ) == TT_OBSTACLE ) ||
-                                        ( GET_TILE_TYPE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width - 1 ) ) == TT_OBSTACLE )
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height ), PIXEL_TO_CELL_COORD( pos->x.part.integer ) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer - 1 ), PIXEL_TO_CELL_COORD( pos->x.part.integer ) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer + g->height ), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width - 1) ) ||
+                                        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( pos->y.part.integer - 1), PIXEL_TO_CELL_COORD( pos->x.part.integer + g->width - 1 ) )
                                     ) )
                                 ) { // then
                                 move->data.linear.dy = -move->data.linear.dy;
@@ -30,6 +30,15 @@
 #include "rage1/banked.h"
 
 // auxiliary functions for hero_can_move_in_direction()
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+uint8_t hero_can_move_vertical( uint8_t x, uint8_t r, uint8_t c ) {
+    return ! btile_obstacle_in_row_span( r, PIXEL_TO_CELL_COORD( x ), c );
+}
+
+uint8_t hero_can_move_horizontal( uint8_t y, uint8_t r, uint8_t c ) {
+    return ! btile_obstacle_in_col_span( c, PIXEL_TO_CELL_COORD( y ), r );
+}
+#else
 uint8_t hero_can_move_vertical( uint8_t x, uint8_t r, uint8_t c ) {
     uint8_t i;
     for ( i = PIXEL_TO_CELL_COORD( x ) ; i <= c ; i++ )
@@ -45,6 +54,7 @@ uint8_t hero_can_move_horizontal( uint8_t y, uint8_t r, uint8_t c ) {
             return 0;
     return 1;
 }
+#endif
 
 uint8_t hero_can_move_in_direction( uint8_t direction ) __z88dk_fastcall {
     static uint8_t r,c;
@@ -258,6 +268,7 @@ void hero_animate_and_move( void ) {
         pos->ymax = pos->y.part.integer + HERO_SPRITE_HEIGHT - 1;
         anim->last_frame_ptr = animation_frame;
         SET_LOOP_FLAG( F_LOOP_REDRAW_HERO );
+        HOTZONE_OCCUPANCY_INVALIDATE();
     }
 }
 
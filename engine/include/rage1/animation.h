@@ -13,6 +13,8 @@
 
 #include <stdint.h>
 
+#include "features.h"
+
 // an animation sequence is an array of frame numbers
 // the frame numbers in a sequence are used to show the corresponding frame for the sprite
 struct animation_sequence_s {
@@ -28,6 +30,9 @@ struct animation_data_s {
     struct {
         uint8_t frame_delay;		// frames are changed every 'frame_delay' calls
         uint8_t sequence_delay;		// a sequence is repeated after waiting 'sequence_delay' screen frames
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+        uint8_t clock;			// animation clock, delays are in clock periods
+#endif
     } delay_data;
     struct {
         uint8_t initial_sequence;	// sequence to activate when resetting
@@ -44,4 +49,21 @@ uint8_t animation_sequence_tick( struct animation_data_s *anim, uint8_t max_fram
 void animation_set_sequence( struct animation_data_s *anim, uint8_t sequence );
 void animation_reset_state( struct animation_data_s *anim );
 
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+// Animation clocks: animations whose delays are multiples of the same
+// period share a clock, which is ticked once per call of the animate
+// functions.  Animations are only ticked when their clock fires.  Clock
+// tables are generated by datagen, and are ended by a clock with period 0
+struct animation_clock_s {
+    uint8_t period;
+    uint8_t counter;
+    uint8_t fired;
+};
+
+void animation_clocks_tick( struct animation_clock_s *clocks );
+void animation_clocks_reset( struct animation_clock_s *clocks );
+
+#define ANIMATION_CLOCK_FIRED(clocks,anim)	( (clocks)[ (anim)->delay_data.clock ].fired )
+#endif
+
 #endif	// _ANIMATION_H
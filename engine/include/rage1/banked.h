@@ -18,26 +18,11 @@
 #include "rage1/dataset.h"
 #include "rage1/bullet.h"
 
-// shared data between low memory and banked code
-struct main_shared_data_s {
-    struct game_state_s *game_state;
-    struct dataset_assets_s *home_assets;
-    struct dataset_assets_s *banked_assets;
-    uint8_t *screen_pos_tile_type_data;
-    struct bullet_state_data_s *bullet_state_data;
-};
-extern struct main_shared_data_s main_shared_data;
-void init_banked_code( void );
-
-// only process this file if building banked code
-#ifdef _BANKED_CODE_BUILD
-
-    #define	game_state			( *main_shared_data.game_state )
-    #define	screen_pos_tile_type_data	( main_shared_data.screen_pos_tile_type_data )
-    #define	home_assets			( main_shared_data.home_assets )
-    #define	banked_assets			( main_shared_data.banked_assets )
-    #define	bullet_state_data		( main_shared_data.bullet_state_data )
-
-#endif // _BANKED_CODE_BUILD
+// Banked code accesses the data in low memory (game_state, home_assets,
+// banked_assets, screen_pos_tile_type_data, bullet_state_data) directly
+// by their symbols, using the extern declarations in the regular RAGE1
+// headers.  When building in 128K mode, the banked code is linked against
+// the addresses of those symbols in main.map.  The list of symbols is in
+// engine/banked_code/main_symbols.asm.in
 
 #endif // _BANKED_H
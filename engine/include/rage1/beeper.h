@@ -27,4 +27,12 @@ void beeper_play_pending_fx( void );
 // plays a beeper fx
 void beeper_play_fx( void *sfx );
 
+#ifdef BUILD_FEATURE_BEEPER_ISR_FX
+// interrupt driven player: renders a slice of the current FX, called from the ISR
+void beeper_do_periodic_tasks( void );
+
+// returns the priority of a given FX, as set with SOUND_PRIORITY - generated by datagen
+uint8_t beeper_fx_get_priority( void *sfx );
+#endif
+
 #endif //_BEEPER_H
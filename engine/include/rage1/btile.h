@@ -21,6 +21,41 @@
 // rectangular form. Array is in row form. Tiles can be either
 // <256, for regular UDGs, or >=256 for address-specified ones
 
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS
+
+// With cell offsets, each btile frame is a single stream of cell records in
+// row order: the offset of the cell graphic into the dataset btile arena
+// (8 or 16 bits), followed by the cell attribute when the game area is in
+// full color.  The 16 bit offsets are stored little endian.  The arena base
+// is kept only once per dataset, in its dataset_assets_s
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS_8BIT
+    #define BTILE_CELL_OFFSET(p)	( *(p) )
+    #define BTILE_CELL_OFFSET_SIZE	1
+#else
+    #define BTILE_CELL_OFFSET(p)	( *(uint16_t *)(p) )
+    #define BTILE_CELL_OFFSET_SIZE	2
+#endif
+
+// struct for defining a big tile frame
+struct btile_frame_s {
+    uint8_t *cells;
+};
+
+// struct for defining a big tile
+struct btile_s {
+    uint8_t num_rows,num_cols;
+#ifdef BUILD_FEATURE_ANIMATED_BTILES
+    uint8_t num_frames;
+    struct btile_frame_s *frames;
+    uint8_t num_sequences;
+    struct animation_sequence_s *sequences;
+#else
+    uint8_t *cells;
+#endif
+};
+
+#else // BUILD_FEATURE_BTILE_CELL_OFFSETS
+
 // struct for defining a big tile frame
 struct btile_frame_s {
     uint8_t **tiles;
@@ -45,6 +80,8 @@ struct btile_s {
 #endif
 };
 
+#endif // BUILD_FEATURE_BTILE_CELL_OFFSETS
+
 // struct for defining a tile's position on a given screen
 struct btile_pos_s {
     uint8_t type;
@@ -58,16 +95,24 @@ struct animated_btile_s {
     uint16_t btile_id;			// for efficiency
     uint8_t btile_pos_id;
     struct animation_data_s anim;
+    struct btile_s *btile;		// cached on screen entry
+    uint8_t max_frames;			// cached on screen entry
 };
 
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
 void btile_draw_frame( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_rect_t *box, uint8_t num_frame );
 void btile_animate_all( void );
+void btile_animation_reset_all( uint16_t num_btiles, struct animated_btile_s *btiles );
 #endif
 
 void btile_draw( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_rect_t *box );
 void btile_remove( uint8_t row, uint8_t col, struct btile_s *b );
 
+// btiles drawn between btile_batch_begin() and btile_batch_end() are not
+// invalidated one by one: the given area is invalidated at the end
+void btile_batch_begin( void );
+void btile_batch_end( gfx_rect_t *area ) __z88dk_fastcall;
+
 // tile types
 
 // decoration: sprites pass through it
@@ -82,24 +127,89 @@ void btile_remove( uint8_t row, uint8_t col, struct btile_s *b );
 // crumb type in lower 4 bits, so tile types 0x10 to 0x1F belong to crumbs
 #define TT_CRUMB	0x10
 
+#ifdef BUILD_FEATURE_BTILE_OBJECT_SLOTS
+// object slots: the cells of items and crumbs have the index of the item or
+// crumb in the current screen encoded in the tile type, so that it is found
+// without searching.  Items are 0x80-0xBF and crumbs are 0x40-0x7F, with the
+// index in the lower 6 bits
+#define TT_ITEM_SLOTS		0x80
+#define TT_CRUMB_SLOTS		0x40
+#define TT_SLOT(t)		( (t) & 0x3F )
+#define TT_ITEM_TYPE(slot)		( TT_ITEM_SLOTS | (slot) )
+#define TT_CRUMB_TYPE(slot,ctype)	( TT_CRUMB_SLOTS | (slot) )
+#define IS_TT_ITEM(t)		( ( (t) & 0xC0 ) == TT_ITEM_SLOTS )
+#define IS_TT_CRUMB(t)		( ( (t) & 0xC0 ) == TT_CRUMB_SLOTS )
+#else
+#define TT_ITEM_TYPE(slot)		TT_ITEM
+#define TT_CRUMB_TYPE(slot,ctype)	( TT_CRUMB | (ctype) )	// crumb type is in lower nibble
+#define IS_TT_ITEM(t)		( (t) == TT_ITEM )
+#define IS_TT_CRUMB(t)		( ( (t) & TT_CRUMB ) == TT_CRUMB )
+#endif
+
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+// precompiled: the tile type for this btile is already in the screen's
+// precompiled type map, so btile_draw() does not update the type map
+#define TT_PRECOMPILED	0xFF
+#endif
+
 // array which contains the btile type on each position of the screen
 // also, macro for getting the btile type at a given screen position
 extern uint8_t screen_pos_tile_type_data[];
 
 #ifdef BUILD_FEATURE_BTILE_2BIT_TYPE_MAP
     #define GET_TILE_TYPE_AT(srow,scol)		( btile_get_tile_type( (srow), (scol) ) )
-    #define SET_TILE_TYPE_AT(srow,scol,sval)	( btile_set_tile_type( (srow), (scol), (sval) ) )
+    #define SET_TILE_TYPE_MAP_AT(srow,scol,sval)	( btile_set_tile_type( (srow), (scol), (sval) ) )
 #else
     #define GET_TILE_TYPE_AT(srow,scol)		( screen_pos_tile_type_data[ (srow) * 32 + (scol) ] )
-    #define SET_TILE_TYPE_AT(srow,scol,sval)	( screen_pos_tile_type_data[ (srow) * 32 + (scol) ] = (sval) )
+    #define SET_TILE_TYPE_MAP_AT(srow,scol,sval)	( screen_pos_tile_type_data[ (srow) * 32 + (scol) ] = (sval) )
+#endif
+
+// the obstacle bitmap, if used, is updated together with the tile type map
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+    #define SET_TILE_TYPE_AT(srow,scol,sval)	do { SET_TILE_TYPE_MAP_AT( (srow), (scol), (sval) ); btile_set_obstacle( (srow), (scol), (sval) ); } while (0)
+#else
+    #define SET_TILE_TYPE_AT(srow,scol,sval)	SET_TILE_TYPE_MAP_AT( (srow), (scol), (sval) )
 #endif
 
 // Accelerated functions for getting/setting tile types
 uint8_t btile_get_tile_type( uint8_t row, uint8_t col );
 void btile_set_tile_type( uint8_t row, uint8_t col, uint8_t type );
 
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+// Obstacle bitmap: 1 bit per screen position, set if the tile type at that
+// position is TT_OBSTACLE.  It is kept updated alongside the tile type map.
+// 4 bytes per row, bit 7 of each byte is the leftmost column
+#define OBSTACLE_BITMAP_SIZE	( 24 * 4 )
+extern uint8_t screen_obstacle_bitmap[];
+
+// bit masks for a column inside its bitmap byte, and for the columns from
+// a given one to the right/left end of its byte
+extern uint8_t obstacle_bitmap_bit[];
+extern uint8_t obstacle_bitmap_first_mask[];
+extern uint8_t obstacle_bitmap_last_mask[];
+
+#define IS_OBSTACLE_AT(srow,scol)	( screen_obstacle_bitmap[ ( (srow) << 2 ) + ( (scol) >> 3 ) ] & obstacle_bitmap_bit[ (scol) & 0x07 ] )
+
+// span queries: return non-zero if there is any obstacle in the given row
+// between columns c1 and c2, or in the given column between rows r1 and r2
+// (both included, c1 <= c2, r1 <= r2)
+uint8_t btile_obstacle_in_row_span( uint8_t row, uint8_t c1, uint8_t c2 );
+uint8_t btile_obstacle_in_col_span( uint8_t col, uint8_t r1, uint8_t r2 );
+
+// updates the bitmap bit for a position with the given tile type
+void btile_set_obstacle( uint8_t row, uint8_t col, uint8_t type );
+#else
+#define IS_OBSTACLE_AT(srow,scol)	( GET_TILE_TYPE_AT( (srow), (scol) ) == TT_OBSTACLE )
+#endif
+
 void btile_clear_type_all_screen(void);
 
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+// loads the tile type map, and the obstacle bitmap if used, from the
+// precompiled RLE data for a screen
+void btile_load_type_map( uint8_t *rle ) __z88dk_fastcall;
+#endif
+
 // btile flags macros and definitions
 #define GET_BTILE_FLAG(s,f)	( (s) & (f) )
 #define SET_BTILE_FLAG(s,f)	( (s) |= (f) )
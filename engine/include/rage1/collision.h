@@ -20,4 +20,10 @@ uint8_t collision_check( struct position_data_s *a,struct position_data_s *b );
 void collision_check_hero_with_sprites( void );
 void collision_check_bullets_with_sprites( void );
 
+#ifdef BUILD_FEATURE_COLLISION_GRID
+// rebuilds the enemy collision grid, must be called once per frame before
+// the collision checks
+void collision_grid_build( void );
+#endif
+
 #endif // _COLLISION_H
@@ -43,4 +43,22 @@ uint8_t controller_read_state(void);
 uint8_t controller_pause_key_pressed(void);
 void controller_reset_all(void);
 
+#ifdef BUILD_FEATURE_INPUT_REPLAY
+// Input record/replay: the controller state for each game loop iteration
+// is stored as an RLE stream of (count,value) byte pairs.  When recording,
+// the stream goes to memory bank INPUT_REPLAY_BANK, prefixed with its
+// 16-bit length (see tools/r1replay.pl); when replaying, it is read from
+// input_replay_data[] in game_data.c
+void controller_input_replay_reset( void );
+
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+#define INPUT_REPLAY_RECORD_ADDRESS	0xC000
+#define INPUT_REPLAY_RECORD_MAX_SIZE	( 0x4000 - 2 )
+// stores a pair at the given stream offset and updates the stream length.
+// Defined in 00lowmem.c, since it switches the memory bank at $C000
+void input_replay_store( uint16_t offset, uint8_t count, uint8_t value );
+#endif
+
+#endif // BUILD_FEATURE_INPUT_REPLAY
+
 #endif // _CONTROLLER_H
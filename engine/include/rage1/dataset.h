@@ -36,6 +36,10 @@ struct dataset_assets_s {
     // max: 65536 BTILEs in a dataset
     uint16_t				num_btiles;
     struct btile_s			*all_btiles;
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS
+    // base for the btile cell offsets, shared by all btiles in the dataset
+    uint8_t				*btile_arena;
+#endif
     // Sprites
     uint8_t				num_sprite_graphics;
     // max: 256 sprites in a dataset
@@ -69,6 +73,40 @@ extern struct dataset_info_s dataset_info[];
 // invalid dataset to signal that a new one needs to be mapped
 #define NO_DATASET	0xff
 
+// max number of prefetch candidate datasets for each screen
+#define DATASET_PREFETCH_NUM_CANDIDATES	2
+
+#ifdef BUILD_FEATURE_DATASET_CACHE
+// Dataset cache: decompressed datasets are kept in memory banks that are
+// not used for datasets or codesets, so that a recently used dataset can
+// be reactivated with a plain copy instead of decompressing it again.
+// Each bank holds one cached dataset, at 0xC000.  Slots are kept in LRU
+// order: slot 0 is the most recently used one
+
+// tables autogenerated by BANKTOOL
+extern uint8_t dataset_cache_banks[];
+extern uint16_t dataset_uncompressed_size[];
+
+struct dataset_cache_slot_s {
+    uint8_t	dataset;	// cached dataset, NO_DATASET if the slot is free
+    uint8_t	bank_num;	// memory bank for this slot
+};
+
+// cache statistics, can be checked with the debugger
+extern uint16_t dataset_cache_hits;
+extern uint16_t dataset_cache_misses;
+#endif
+
+#ifdef BUILD_FEATURE_DATASET_PREFETCH
+// Dataset prefetch: the most likely datasets to be needed after each screen
+// (autogenerated by DATAGEN) are decompressed into the dataset cache in the
+// background, a few bytes on each game loop
+extern uint8_t screen_prefetch_datasets[][ DATASET_PREFETCH_NUM_CANDIDATES ];
+void dataset_prefetch_start( uint8_t d ) __z88dk_fastcall;
+void dataset_prefetch_step( void );
+void dataset_prefetch_screen_neighbours( uint8_t screen_num ) __z88dk_fastcall;
+#endif
+
 // dataset initialization at program start
 void init_datasets( void );
 
@@ -29,6 +29,9 @@ struct  enemy_movement_data_s {
             uint8_t initx,inity;		// reset positions
             int8_t initdx,initdy;		// reset increments
             uint8_t sequence_a, sequence_b;	// sprite animation sequences (see FLAGS)
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+            uint8_t limit_min, limit_max;	// configured limits on the movement axis (see FLAGS)
+#endif
         } linear;
     } data;
     uint8_t flags;				// movement flags
@@ -60,10 +63,12 @@ struct enemy_info_s {
 #define F_ENEMY_MOVE_BOUNCE			0x01
 #define F_ENEMY_MOVE_CHANGE_SEQUENCE_VERT	0x02
 #define F_ENEMY_MOVE_CHANGE_SEQUENCE_HORIZ	0x04
+#define F_ENEMY_MOVE_BOUNCE_LIMITS		0x08
 
 #define ENEMY_MOVE_MUST_BOUNCE(s)			(GET_ENEMY_MOVE_FLAG((s),F_ENEMY_MOVE_BOUNCE))
 #define ENEMY_MOVE_CHANGES_SEQUENCE_VERT(s)		(GET_ENEMY_MOVE_FLAG((s),F_ENEMY_MOVE_CHANGE_SEQUENCE_VERT))
 #define ENEMY_MOVE_CHANGES_SEQUENCE_HORIZ(s)		(GET_ENEMY_MOVE_FLAG((s),F_ENEMY_MOVE_CHANGE_SEQUENCE_HORIZ))
+#define ENEMY_MOVE_HAS_BOUNCE_LIMITS(s)			(GET_ENEMY_MOVE_FLAG((s),F_ENEMY_MOVE_BOUNCE_LIMITS))
 
 // sets all enemies in a enemy set to initial positions and frames
 void enemy_reset_position_all( uint8_t num_enemies, struct enemy_info_s *enemies );
@@ -77,4 +82,21 @@ void enemy_redraw_all( uint8_t num_enemies, struct enemy_info_s *enemies );
 
 void enemy_move_offscreen_all( uint8_t num_enemies, struct enemy_info_s *enemies );
 
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+// Bouncing enemies that move along a single axis have their xmin/xmax (or
+// ymin/ymax) limits clipped against the obstacles by datagen, so that they
+// only need a compare on each step.  On screens with btiles that can be
+// enabled or disabled the limits must be recalculated when that happens,
+// starting from the enemy current position
+void enemy_update_bounce_limits( struct enemy_info_s *e ) __z88dk_fastcall;
+void enemy_update_bounce_limits_all( void );
+#endif
+
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+// the active enemy list is rebuilt in enemy_reset_position_all(), and must
+// be updated with these functions when an enemy is enabled or disabled
+void enemy_active_list_add( uint8_t n ) __z88dk_fastcall;
+void enemy_active_list_remove( uint8_t n ) __z88dk_fastcall;
+#endif
+
 #endif // _ENEMY_H
@@ -51,8 +51,10 @@
 #define RULE_CHECK_GAME_TIME_LESS_THAN		25
 #define RULE_CHECK_GAME_EVENT_HAPPENED		26
 #define RULE_CHECK_ITEM_IS_NOT_OWNED		27
+#define RULE_CHECK_HERO_ENTERED_HOTZONE		28
+#define RULE_CHECK_HERO_LEFT_HOTZONE		29
 
-#define RULE_CHECK_MAX				27
+#define RULE_CHECK_MAX				29
 
 struct flow_rule_check_s {
     uint8_t type;
@@ -63,7 +65,7 @@ struct flow_rule_check_s {
         struct { uint16_t	count; }		enemies;	// ENEMIES_ALIVE_*, ENEMIES_KILLED_*
         struct { uint8_t	function_id, param; }	custom;		// CALL_CUSTOM_FUNCTION
         struct { uint16_t	item_id; }		item;		// ITEM_IS_OWNED/NOT_OWNED
-        struct { uint8_t	num_hotzone; }		hotzone;	// HERO_INSIDE_HOTZONE
+        struct { uint8_t	num_hotzone; }		hotzone;	// HERO_OVER/ENTERED/LEFT_HOTZONE
         struct { uint8_t	var_id, value; }	flow_var;	// FLOW_VAR_*
         struct { uint16_t	seconds; }		game_time;	// GAME_TIME_*
         struct { uint8_t	event; }		game_event;	// GAME_EVENT_HAPPENED
@@ -139,6 +141,33 @@ struct flow_rule_action_s {
 #define ACTION_WARP_TO_SCREEN_KEEP_HERO_X	(0x01)
 #define ACTION_WARP_TO_SCREEN_KEEP_HERO_Y	(0x02)
 
+////////////////////////////////////////////////
+//
+// FLOWGEN RULE DEPENDENCIES
+//
+////////////////////////////////////////////////
+
+// Game state classes that can be read by rule checks.  DATAGEN computes for
+// each rule the OR of the classes read by all its checks, and the engine
+// keeps a dirty mask with the classes that have been modified since a rule
+// table was last run.  A rule whose checks do not read anything that has
+// changed does not need to have its checks evaluated again, the cached
+// result from the last evaluation is used instead
+#define FLOW_DEP_GAME_FLAGS		0x0001
+#define FLOW_DEP_LOOP_FLAGS		0x0002
+#define FLOW_DEP_USER_FLAGS		0x0004
+#define FLOW_DEP_LIVES			0x0008
+#define FLOW_DEP_ENEMIES		0x0010
+#define FLOW_DEP_INVENTORY		0x0020
+#define FLOW_DEP_HOTZONES		0x0040
+#define FLOW_DEP_SCREEN_FLAGS		0x0080
+#define FLOW_DEP_FLOW_VARS		0x0100
+#define FLOW_DEP_GAME_TIME		0x0200
+#define FLOW_DEP_GAME_EVENTS		0x0400
+// checks that can't be tracked (e.g. custom functions) must be always evaluated
+#define FLOW_DEP_ALWAYS			0x8000
+#define FLOW_DEP_ALL			0xffff
+
 // data definition for a rule
 struct flow_rule_s {
     // what to check
@@ -147,6 +176,12 @@ struct flow_rule_s {
     // what to do if all checks are successful
     uint8_t num_actions;
     struct flow_rule_action_s *actions;
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+    // state classes read by the checks, and cached result of the last
+    // evaluation of the checks
+    uint16_t deps;
+    uint8_t checks_ok;
+#endif
 };
 
 struct flow_rule_table_s {
@@ -158,8 +193,37 @@ struct flow_rule_table_s {
 typedef uint8_t (*check_custom_function_t)( uint8_t param );
 typedef void (*action_custom_function_t)( uint8_t param );
 
+#ifdef BUILD_FEATURE_FLOW_COMPILED_RULES
+// compiled rules: DATAGEN generates a function for each rule table, and a
+// table indexed by global screen number with the functions for each screen
+// (NULL if the screen has no rules for that table)
+typedef void (*flow_compiled_rule_table_t)( void );
+
+struct flow_compiled_screen_rules_s {
+    flow_compiled_rule_table_t enter_screen;
+    flow_compiled_rule_table_t exit_screen;
+    flow_compiled_rule_table_t game_loop;
+};
+
+extern struct flow_compiled_screen_rules_s all_screen_compiled_rules[];
+void flow_compiled_game_events_rules( void );
+#endif
+
+// helpers used by rule checks
+uint8_t flow_hero_over_hotzone( uint8_t num_hotzone ) __z88dk_fastcall;
+
 // executes user flow rules
 void check_flow_rules( void );
 void check_game_event_rules( void );
 
+// flags some state classes as modified, so that rules that depend on them
+// are evaluated again.  State changes done through the usual game_state
+// macros already do this, but custom code that modifies other state (e.g.
+// flow vars) directly must call this
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+#define FLOW_MARK_DIRTY(m)	( game_state.flow_dirty |= (m) )
+#else
+#define FLOW_MARK_DIRTY(m)	do { } while (0)
+#endif
+
 #endif //_FLOW_H
@@ -19,21 +19,71 @@
 
 void run_main_game_loop(void);
 
-// Use this macro to run a function only once per frame.  Invoke it just at
-// the beginning of the function this way:
+// Game loop task scheduler
 //
-// void do_domething(void) {
-//     RUN_ONLY_ONCE_PER_FRAME;
-//     ...
-//     (code)
-//     ...
-// }
+// The throttled tasks of the game loop are run through a table which
+// gives each one a period (run every N frames), a phase offset and a
+// priority.  Each task is invoked at its usual place in the game loop with
+// game_loop_run_task( GAME_LOOP_TASK_xxx ), which runs it only if it is
+// due.  High priority tasks always run when due.  If a frame budget is
+// configured (GAME_LOOP_FRAME_BUDGET frames), low priority ones slip to the
+// next loop iteration if the current one has already used it up, and then
+// run on that next iteration whatever its time: a task is never deferred
+// more than once.
 //
-// The global frame counter in the current_time struct is updated in the
-// background via interrupts.  If the function has already been called in
-// this frame, it will return immediately; otherwise, it will update the
-// current frame number and continue with the rest of the function code
+// Periods, phases, priorities and the budget are configured with TASK and
+// SCHEDULER directives in GAME_CONFIG.  By default all tasks run once per
+// frame and there is no budget, so no task is ever deferred.
 
-#define RUN_ONLY_ONCE_PER_FRAME		static uint8_t __last_frame; if ( __last_frame == current_time.frame ) return; else __last_frame = current_time.frame
+#define GAME_LOOP_TASK_PRIORITY_LOW	0
+#define GAME_LOOP_TASK_PRIORITY_HIGH	1
+
+struct game_loop_task_s {
+    void (*run)( void );
+    uint8_t period;
+    uint8_t phase;
+    uint8_t priority;
+    uint8_t remaining;		// frames until the task is due again
+    uint8_t slipped;		// deferred once, must run on the next iteration
+};
+
+// task ids: indexes into the task table
+enum {
+    GAME_LOOP_TASK_ENEMIES = 0,
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+    GAME_LOOP_TASK_BULLETS,
+#endif
+    GAME_LOOP_TASK_HERO,
+    GAME_LOOP_TASK_COLLISIONS,
+#ifdef BUILD_FEATURE_ANIMATED_BTILES
+    GAME_LOOP_TASK_BTILES,
+#endif
+#ifdef BUILD_FEATURE_GAME_TIME
+    GAME_LOOP_TASK_TIMERS,
+#endif
+#ifdef BUILD_FEATURE_GAME_LOOP_HEARTBEAT
+    GAME_LOOP_TASK_HEARTBEAT,
+#endif
+    GAME_LOOP_NUM_TASKS
+};
+
+// resets all tasks to their initial phase
+void game_loop_reset_tasks( void );
+
+// accounts for the frames elapsed since the previous loop iteration; must
+// be called once at the start of each iteration
+void game_loop_update_tasks( void );
+
+// returns true and rearms the given task if it is due
+uint8_t game_loop_task_is_due( uint8_t task_id ) __z88dk_fastcall;
+
+// runs the given task if it is due
+void game_loop_run_task( uint8_t task_id ) __z88dk_fastcall;
+
+#ifdef BUILD_FEATURE_ZX_TARGET_128
+// runs the due enemies and bullets tasks with a single banked section for
+// their movement code, then reads the controller and runs the hero task
+void game_loop_run_move_tasks( void );
+#endif
 
 #endif // _GAME_LOOP_H
@@ -107,8 +107,22 @@ struct game_state_s {
    uint16_t enemies_alive;
    uint16_t enemies_killed;
 
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+   // dense list of the indexes of the active enemies in the current screen,
+   // so that per-frame enemy loops do not need to skip inactive ones
+   uint8_t num_active_enemies;
+   uint8_t active_enemies[ MAX_ENEMIES_PER_SCREEN ];
+#endif
+
    // pointer to beeper sound fx to play when required
    void *beeper_fx;
+#ifdef BUILD_FEATURE_BEEPER_ISR_FX
+   // beeper fx requests for the interrupt driven player: the main loop
+   // adds them at head and the ISR consumes them at tail
+   void *beeper_fx_queue[ BEEPER_FX_QUEUE_SIZE ];
+   uint8_t beeper_fx_queue_head;
+   uint8_t beeper_fx_queue_tail;
+#endif
    // id of tracker sound fx to play when required
    uint16_t tracker_fx;
 
@@ -125,6 +139,23 @@ struct game_state_s {
 #ifndef BUILD_FEATURE_GAMEAREA_COLOR_FULL
    uint8_t default_mono_attr;
 #endif
+
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+   // FLOW_DEP_* state classes modified since the rule tables were last run
+   uint16_t flow_dirty;
+#endif
+
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+   // hotzones of the current screen that the hero is over, and the ones
+   // entered and left since the previous update (1 bit per hotzone).  See
+   // hotzone.h
+   struct {
+      uint16_t over;
+      uint16_t entered;
+      uint16_t left;
+      uint8_t stale;
+   } hotzones;
+#endif
 };
 
 extern struct game_state_s game_state;
@@ -134,15 +165,22 @@ void game_state_reset_initial(void);
 
 // manage game state when moving to a new screen
 void game_state_switch_to_next_screen( void );
+void game_state_switch_screen_finish( void );
 
 ///////////////////////////////////////////////
 // game flags macros and definitions
 ///////////////////////////////////////////////
 
 #define GET_GAME_FLAG(f)	(game_state.flags & (f))
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+#define SET_GAME_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_GAME_FLAGS), game_state.flags |= (f))
+#define RESET_GAME_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_GAME_FLAGS), game_state.flags &= ~(f))
+#define RESET_ALL_GAME_FLAGS()	(FLOW_MARK_DIRTY(FLOW_DEP_GAME_FLAGS), game_state.flags = 0)
+#else
 #define SET_GAME_FLAG(f)	(game_state.flags |= (f))
 #define RESET_GAME_FLAG(f)	(game_state.flags &= ~(f))
 #define RESET_ALL_GAME_FLAGS()	(game_state.flags = 0)
+#endif
 
 // player has exhausted his lives
 #define F_GAME_OVER			0x0001
@@ -160,9 +198,16 @@ void game_state_switch_to_next_screen( void );
 ///////////////////////////////////////////////
 
 #define GET_LOOP_FLAG(f)	(game_state.loop_flags & (f))
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+// loop flags are reset on every loop, only flag them as dirty if some was set
+#define SET_LOOP_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_LOOP_FLAGS), game_state.loop_flags |= (f))
+#define RESET_LOOP_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_LOOP_FLAGS), game_state.loop_flags &= ~(f))
+#define RESET_ALL_LOOP_FLAGS()	do { if ( game_state.loop_flags ) { FLOW_MARK_DIRTY(FLOW_DEP_LOOP_FLAGS); game_state.loop_flags = 0; } } while (0)
+#else
 #define SET_LOOP_FLAG(f)	(game_state.loop_flags |= (f))
 #define RESET_LOOP_FLAG(f)	(game_state.loop_flags &= ~(f))
 #define RESET_ALL_LOOP_FLAGS()	(game_state.loop_flags = 0)
+#endif
 
 
 // 0x0001 value unused
@@ -182,9 +227,16 @@ void game_state_switch_to_next_screen( void );
 ///////////////////////////////////////////////
 
 #define GET_GAME_EVENT(f)	(game_state.game_events & (f))
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+// game events are reset on every loop, only flag them as dirty if some was set
+#define SET_GAME_EVENT(f)	(FLOW_MARK_DIRTY(FLOW_DEP_GAME_EVENTS), game_state.game_events |= (f))
+#define RESET_GAME_EVENT(f)	(FLOW_MARK_DIRTY(FLOW_DEP_GAME_EVENTS), game_state.game_events &= ~(f))
+#define RESET_ALL_GAME_EVENTS()	do { if ( game_state.game_events ) { FLOW_MARK_DIRTY(FLOW_DEP_GAME_EVENTS); game_state.game_events = 0; } } while (0)
+#else
 #define SET_GAME_EVENT(f)	(game_state.game_events |= (f))
 #define RESET_GAME_EVENT(f)	(game_state.game_events &= ~(f))
 #define RESET_ALL_GAME_EVENTS()	(game_state.game_events = 0)
+#endif
 
 // player has received a hit
 #define E_HERO_WAS_HIT			0x0001
@@ -198,15 +250,25 @@ void game_state_switch_to_next_screen( void );
 #define E_HERO_DIED			0x0010
 // a bullet was shot
 #define E_BULLET_WAS_SHOT		0x0020
+// the hero entered some hotzone
+#define E_HERO_ENTERED_HOTZONE		0x0040
+// the hero left some hotzone
+#define E_HERO_LEFT_HOTZONE		0x0080
 
 ///////////////////////////////////////////////
 // user flags macros and definitions
 ///////////////////////////////////////////////
 
 #define GET_USER_FLAG(f)	(game_state.user_flags & (f))
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+#define SET_USER_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_USER_FLAGS), game_state.user_flags |= (f))
+#define RESET_USER_FLAG(f)	(FLOW_MARK_DIRTY(FLOW_DEP_USER_FLAGS), game_state.user_flags &= ~(f))
+#define RESET_ALL_USER_FLAGS()	(FLOW_MARK_DIRTY(FLOW_DEP_USER_FLAGS), game_state.user_flags = 0)
+#else
 #define SET_USER_FLAG(f)	(game_state.user_flags |= (f))
 #define RESET_USER_FLAG(f)	(game_state.user_flags &= ~(f))
 #define RESET_ALL_USER_FLAGS()	(game_state.user_flags = 0)
+#endif
 
 
 #endif // _GAME_STATE_H
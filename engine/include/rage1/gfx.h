@@ -44,6 +44,8 @@
 //     gfx_sprite_get_width(s)
 //     gfx_sprite_get_height(s)
 //     gfx_tile_put(row, col, attr, tile)
+//     gfx_tile_put_noinv(row, col, attr, tile)
+//     gfx_invalidate_tiles(rect)
 //     gfx_tile_register(index, graphic)
 //     gfx_clear_rect(rect, attr, ch, flags)
 //     gfx_print_set_pos(ctx, row, col)
@@ -68,6 +70,9 @@
 // Real functions (multi-step, backend-specific body in .c files)
 void gfx_init( uint8_t bg_attr, uint8_t bg_char );
 gfx_sprite_t *gfx_sprite_create( uint8_t rows, uint8_t cols );
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+gfx_sprite_t *gfx_sprite_create_preshifted( uint8_t rows, uint8_t cols );
+#endif
 void gfx_sprite_set_color( gfx_sprite_t *s, uint8_t color );
 
 // global initialization
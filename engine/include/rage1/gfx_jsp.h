@@ -49,6 +49,10 @@ typedef struct jsp_print_ctx     gfx_print_ctx_t;
 
 //--- Tile drawing ---
 #define gfx_tile_put(r,c,attr,tile)         jsp_tile_put((r),(c),(attr),(tile))
+// jsp_tile_put already marks its cell dirty in the DTT, which is just a bit
+// set, so there is no separate non-invalidating version
+#define gfx_tile_put_noinv(r,c,attr,tile)   jsp_tile_put((r),(c),(attr),(tile))
+#define gfx_invalidate_tiles(rect)          /* no-op: cells already marked by jsp_tile_put */
 #define gfx_tile_register(idx,gfx)          jsp_tile_register((idx),(gfx))
 
 //--- Rectangle operations ---
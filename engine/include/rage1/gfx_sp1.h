@@ -32,6 +32,7 @@ typedef struct sp1_pss   gfx_print_ctx_t;
 
 //--- Sprite lifecycle ---
 // gfx_sprite_create() is a real function (multi-step), defined in sprite.c
+// gfx_sprite_create_preshifted() is a real function (multi-step), defined in sprite.c
 #define gfx_sprite_destroy(s)                  sp1_DeleteSpr(s)
 // gfx_sprite_set_color() is a real function (multi-step), defined in sprite.c
 #define gfx_sprite_set_threshold(s,xt,yt) \
@@ -49,6 +50,10 @@ typedef struct sp1_pss   gfx_print_ctx_t;
 
 //--- Tile drawing ---
 #define gfx_tile_put(r,c,attr,tile)            sp1_PrintAtInv((r),(c),(attr),(tile))
+// tiles drawn with gfx_tile_put_noinv() are not shown until their cells are
+// invalidated: gfx_invalidate_tiles() must be called for the drawn rectangle
+#define gfx_tile_put_noinv(r,c,attr,tile)      sp1_PrintAt((r),(c),(attr),(tile))
+#define gfx_invalidate_tiles(rect)             sp1_Invalidate(rect)
 #define gfx_tile_register(idx,gfx)             sp1_TileEntry((idx),(gfx))
 
 //--- Rectangle operations ---
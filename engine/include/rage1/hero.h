@@ -104,6 +104,7 @@ void init_hero(void);
 void hero_reset_all(void);
 void hero_reset_position(void);
 void hero_animate_and_move( void );
+uint8_t hero_can_move_in_direction( uint8_t direction ) __z88dk_fastcall;
 void hero_shoot_bullet( void );
 void hero_check_tiles_below(void);
 void hero_update_lives_display(void);
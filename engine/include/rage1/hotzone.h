@@ -31,4 +31,26 @@ uint8_t hotzone_is_inside( struct hotzone_info_s *h, uint8_t x, uint8_t y );
 
 #define F_HOTZONE_ACTIVE	0x0001
 
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+// The hotzones of the current screen that the hero is over are kept in
+// game_state.hotzones as a bitmask, with 1 bit per hotzone.  It is only
+// recalculated when the hero has moved or some hotzone has been enabled or
+// disabled, and the hotzones entered or left at each update are also kept
+// so that rules can react to the transitions without polling
+#define HOTZONE_MAX_OCCUPANCY	16
+#define HOTZONE_BIT(n)		( (uint16_t) 1 << (n) )
+
+// update occupancy once per game loop, clearing the previous transitions
+void hotzone_occupancy_update( void );
+// update occupancy right now, keeping the previous transitions
+void hotzone_occupancy_refresh( void );
+// set occupancy when entering a screen, without transitions
+void hotzone_occupancy_reset( void );
+
+// must be used when the hero position changes
+#define HOTZONE_OCCUPANCY_INVALIDATE()	( game_state.hotzones.stale = 1 )
+#else
+#define HOTZONE_OCCUPANCY_INVALIDATE()	FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES )
+#endif
+
 #endif // _HOTZONE_H
@@ -0,0 +1,23 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _INIT_H
+#define _INIT_H
+
+// initializes the whole program: memory, graphics, interrupts and all the
+// engine subsystems
+void init_program( void );
+
+// initializes the engine subsystems which do not need interrupts.  It is
+// called by init_program() after interrupts have been setup, and by the
+// benchmarks, which run without interrupts
+void init_engine( void );
+
+#endif // _INIT_H
@@ -58,8 +58,13 @@ void inventory_add_item( struct inventory_info_s *inv, uint8_t item );
 
 // inventory management macros
 #define INVENTORY_HAS_ITEM(inv,item)		( (inv)->owned_items & (item) )
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+#define ADD_TO_INVENTORY(inv,item)		( FLOW_MARK_DIRTY( FLOW_DEP_INVENTORY ), (inv)->owned_items |= (item) )
+#define REMOVE_FROM_INVENTORY(inv,item)		( FLOW_MARK_DIRTY( FLOW_DEP_INVENTORY ), (inv)->owned_items &= (~(item) ) )
+#else
 #define ADD_TO_INVENTORY(inv,item)		( (inv)->owned_items |= (item) )
 #define REMOVE_FROM_INVENTORY(inv,item)		( (inv)->owned_items &= (~(item) ) )
+#endif
 
 // flags
 
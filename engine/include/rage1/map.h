@@ -39,6 +39,23 @@ struct map_screen_s {
         uint16_t num_btiles;
         struct btile_pos_s *btiles_pos;
     } btile_data;
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+    // RLE encoded tile type map for the btiles without state, followed by
+    // their obstacle bitmap if BTILE_OBSTACLE_BITMAP is enabled
+    uint8_t *tile_type_map;
+#endif
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+    // pre-rendered btiles without state: RLE encoded grid of the game area
+    // with indexes into the tiles/attrs palette (0 = empty cell).  grid is
+    // NULL if the screen is not pre-rendered
+    struct {
+        uint8_t *grid;
+        uint8_t **tiles;
+#ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
+        uint8_t *attrs;
+#endif
+    } static_layer;
+#endif
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
     struct {
         uint16_t num_btiles;
@@ -99,6 +116,32 @@ extern struct screen_dataset_map_s screen_dataset_map[];
 // code
 void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall;
 void map_enter_screen( uint8_t screen ) __z88dk_fastcall;
+
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+// incremental screen drawing: map_draw_screen_start() clears the game area
+// and map_draw_screen_step() draws at most MAP_DRAW_BTILES_PER_STEP btiles
+// on each call, returning 0 when the screen is complete
+struct map_draw_state_s {
+    struct map_screen_s	*screen;
+    uint8_t		in_progress;
+    uint8_t		phase;
+    uint16_t		index;		// next btile/item/crumb to draw
+    uint8_t		row, col;	// next background position
+};
+extern struct map_draw_state_s map_draw_state;
+
+#define MAP_DRAW_PHASE_BACKGROUND	0
+#define MAP_DRAW_PHASE_BTILES		1
+#define MAP_DRAW_PHASE_ITEMS		2
+#define MAP_DRAW_PHASE_CRUMBS		3
+#define MAP_DRAW_PHASE_DONE		4
+
+void map_draw_screen_start( struct map_screen_s *s ) __z88dk_fastcall;
+uint8_t map_draw_screen_step( void );
+#endif
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+void map_draw_static_layer( struct map_screen_s *s ) __z88dk_fastcall;
+#endif
 void map_exit_screen( struct map_screen_s *s ) __z88dk_fastcall;
 void map_allocate_sprites( struct map_screen_s *m ) __z88dk_fastcall;
 void map_free_sprites( struct map_screen_s *s ) __z88dk_fastcall;
@@ -109,7 +152,12 @@ struct crumb_location_s *map_get_crumb_location_at_position( struct map_screen_s
 // utility macros and definitions
 // screen flags macros and definitions
 #define GET_SCREEN_FLAG(s,f)	( (s) & (f) )
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+#define SET_SCREEN_FLAG(s,f)	( FLOW_MARK_DIRTY( FLOW_DEP_SCREEN_FLAGS ), (s) |= (f) )
+#define RESET_SCREEN_FLAG(s,f)	( FLOW_MARK_DIRTY( FLOW_DEP_SCREEN_FLAGS ), (s) &= ~(f) )
+#else
 #define SET_SCREEN_FLAG(s,f)	( (s) |= (f) )
 #define RESET_SCREEN_FLAG(s,f)	( (s) &= ~(f) )
+#endif
 
 #endif // _MAP_H
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <stdint.h>
+
+#include "features.h"
+
+#include "rage1/interrupts.h"
+
+// Main game loop phases that are measured by the profiler.  The order must
+// match the phase names in tools/r1prof.pl
+#define PROFILER_PHASE_FLOW_RULES	0
+#define PROFILER_PHASE_ENEMIES		1
+#define PROFILER_PHASE_BULLETS		2
+#define PROFILER_PHASE_HERO		3
+#define PROFILER_PHASE_COLLISIONS	4
+#define PROFILER_PHASE_GAME_EVENTS	5
+#define PROFILER_PHASE_LOOP_FLAGS	6
+#define PROFILER_PHASE_BTILES		7
+#define PROFILER_PHASE_GFX_UPDATE	8
+#define PROFILER_PHASE_LOOP		9	// the whole loop iteration
+#define PROFILER_NUM_PHASES		10
+
+#ifdef BUILD_FEATURE_PROFILER
+
+// All times are measured in frames (1/50 s) using the low byte of the
+// interrupt tick counter, so min and max are quantized to whole frames.
+// The average (total/count) is a fair estimation of the real time spent in
+// each phase, since a tick happens inside a phase with a probability which
+// is proportional to its duration
+struct profiler_phase_stats_s {
+    uint8_t	min;
+    uint8_t	max;
+    uint32_t	count;
+    uint32_t	total;
+};
+
+// The profiler data is in low memory, next to current_time, so that it can
+// be found and read from a memory dump or snapshot by r1prof.pl.  Defined
+// in 00asmdata.asm
+struct profiler_data_s {
+    uint8_t	signature[4];		// "R1PF"
+    uint8_t	num_phases;
+    uint8_t	phase_start;
+    uint8_t	loop_start;
+    uint32_t	loop_overruns;		// number of frames lost
+    struct profiler_phase_stats_s phases[ PROFILER_NUM_PHASES ];
+};
+extern struct profiler_data_s profiler_data;
+
+void profiler_reset( void );
+void profiler_phase_end( uint8_t phase ) __z88dk_fastcall;
+void profiler_loop_end( void );
+
+#define PROFILER_PHASE_START()		( profiler_data.phase_start = current_time.ticks_bytes.b0 )
+#define PROFILER_PHASE_END(p)		profiler_phase_end( p )
+#define PROFILER_LOOP_START()		( profiler_data.loop_start = current_time.ticks_bytes.b0 )
+#define PROFILER_LOOP_END()		profiler_loop_end()
+
+#else
+
+#define PROFILER_PHASE_START()
+#define PROFILER_PHASE_END(p)
+#define PROFILER_LOOP_START()
+#define PROFILER_LOOP_END()
+
+#endif // BUILD_FEATURE_PROFILER
+
+#endif // _PROFILER_H
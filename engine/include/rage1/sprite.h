@@ -33,6 +33,12 @@ struct  sprite_graphic_data_s {
         uint8_t num_sequences;
         struct animation_sequence_s *sequences;
     } sequence_data;
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+    // pre-shifted sprites: each frame has 1 << preshift_bits shifted
+    // copies, preshift_stride bytes apart. 0 for regular sprites
+    uint8_t preshift_bits;
+    uint16_t preshift_stride;
+#endif
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -45,6 +51,42 @@ void sprite_move_offscreen( gfx_sprite_t *s ) __z88dk_fastcall;
 // free a sprite
 void sprite_free( gfx_sprite_t *s ) __z88dk_fastcall;
 
+// create a sprite for the given graphic
+gfx_sprite_t *sprite_create( struct sprite_graphic_data_s *g ) __z88dk_fastcall;
+
+// move a sprite to a pixel position in the game area, with the given
+// frame of graphic g.  Pre-shifted sprites select the shifted copy of the
+// frame for the x position, instead of letting the sprite engine rotate it
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+void sprite_move_pixel( gfx_sprite_t *s, struct sprite_graphic_data_s *g, uint8_t *frame, uint8_t x, uint8_t y );
+#else
+#define sprite_move_pixel(s,g,fr,x,y)	gfx_sprite_move_pixel((s),&game_area,(fr),(x),(y))
+#endif
+
+#ifdef BUILD_FEATURE_SPRITE_POOL
+// Enemy sprites are taken from a pool created at startup instead of being
+// created and destroyed on each screen change.  The pool has a class for
+// each sprite size, with as many sprites as the maximum used in any screen
+// - the table is generated by datagen
+struct sprite_pool_class_s {
+    uint8_t rows, cols;
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+    uint8_t preshifted;
+#endif
+    uint8_t num_sprites;
+    uint8_t first;		// index of the first sprite of this class in the pool
+};
+extern struct sprite_pool_class_s sprite_pool_classes[];
+
+void init_sprite_pool( void );
+
+// get a free sprite for the given graphic from the pool
+gfx_sprite_t *sprite_pool_get( struct sprite_graphic_data_s *g ) __z88dk_fastcall;
+
+// return all the sprites to the pool
+void sprite_pool_release_all( void );
+#endif
+
 // callback function and static params to set a sprite attributes
 struct attr_param_s {
     uint8_t attr;
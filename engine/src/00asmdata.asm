@@ -32,6 +32,31 @@ sec:		db	0
 frame:		db	0
 ticks:		dq	0	;; 32-bit
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;
+;; Profiler data for the main game loop phases, only when the profiler is
+;; enabled with RAGE1_PROFILER=1.  It is kept next to current_time so that
+;; it can be easily found in memory dumps.  Declared in profiler.h
+;;
+;; extern struct profiler_data_s profiler_data;
+;;
+
+IFDEF BUILD_FEATURE_PROFILER
+
+defc	PROFILER_NUM_PHASES	= 10	;; must match profiler.h
+defc	PROFILER_PHASE_SIZE	= 10	;; sizeof( struct profiler_phase_stats_s )
+
+public		_profiler_data
+_profiler_data:
+		db	"R1PF"		;; signature
+		db	PROFILER_NUM_PHASES
+		db	0		;; phase_start
+		db	0		;; loop_start
+		dq	0		;; loop_overruns, 32-bit
+		ds	PROFILER_NUM_PHASES * PROFILER_PHASE_SIZE
+
+ENDIF
+
 ;; extern uint8_t periodic_tasks_enabled
 
 public		_periodic_tasks_enabled
@@ -14,6 +14,7 @@
 
 #include "rage1/memory.h"
 #include "rage1/debug.h"
+#include "rage1/controller.h"
 
 #include "game_data.h"
 
@@ -25,6 +26,13 @@ void memory_call_banked_function( uint8_t function_id ) {
 
     uint8_t previous_memory_bank;
 
+    // the engine code bank is already mapped (e.g. called from banked
+    // code): call the function directly
+    if ( memory_current_memory_bank == ENGINE_CODE_MEMORY_BANK ) {
+        run_function[ function_id ]();
+        return;
+    }
+
     // save current memory bank, get the bank number from the codeset info
     // table and switch to the proper bank
     previous_memory_bank = memory_switch_bank( ENGINE_CODE_MEMORY_BANK );
@@ -42,6 +50,12 @@ void memory_call_banked_function_a16( uint8_t function_id, uint16_t arg ) {
 
     uint8_t previous_memory_bank;
 
+    // engine code bank already mapped: call the function directly
+    if ( memory_current_memory_bank == ENGINE_CODE_MEMORY_BANK ) {
+        run_function[ function_id ]( arg );
+        return;
+    }
+
     // save current memory bank, get the bank number from the codeset info
     // table and switch to the proper bank
     previous_memory_bank = memory_switch_bank( ENGINE_CODE_MEMORY_BANK );
@@ -62,6 +76,11 @@ uint8_t memory_call_banked_function_a16_a8_r8( uint8_t function_id, uint16_t arg
     uint8_t previous_memory_bank;
     uint8_t retval;
 
+    // engine code bank already mapped: call the function directly
+    if ( memory_current_memory_bank == ENGINE_CODE_MEMORY_BANK ) {
+        return run_function[ function_id ]( arg1, arg2 );
+    }
+
     // save current memory bank, get the bank number from the codeset info
     // table and switch to the proper bank
     previous_memory_bank = memory_switch_bank( ENGINE_CODE_MEMORY_BANK );
@@ -75,3 +94,21 @@ uint8_t memory_call_banked_function_a16_a8_r8( uint8_t function_id, uint16_t arg
     return retval;
 }
 #endif
+
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+// stores an RLE pair of the recorded input stream in the recording memory
+// bank, and updates the stream length at the start of the bank
+void input_replay_store( uint16_t offset, uint8_t count, uint8_t value ) {
+    uint8_t *buffer = (uint8_t *) INPUT_REPLAY_RECORD_ADDRESS;
+
+    uint8_t previous_memory_bank;
+
+    previous_memory_bank = memory_switch_bank( INPUT_REPLAY_BANK );
+
+    *( (uint16_t *) buffer ) = offset + 2;
+    buffer[ offset + 2 ] = count;
+    buffer[ offset + 3 ] = value;
+
+    memory_switch_bank( previous_memory_bank );
+}
+#endif
@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <z80.h>
+
+#include "features.h"
+
+#include "rage1/beeper.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#ifdef BUILD_FEATURE_BEEPER_ISR_FX
+
+// Interrupt driven beeper FX player.  Effects use the same BeepFX data
+// format as bit_beepfx, but each interrupt renders only one effect frame,
+// truncated to BEEPER_ISR_FX_SLICE loop iterations, so that the effect
+// keeps its original duration without stopping the game.  It must live in
+// non-banked memory since it runs from the ISR.
+//
+// Each loop iteration takes roughly 130 T-states, so the slice is limited
+// to 128 iterations (about 17000 T-states, a quarter of the 69888 T-states
+// of a 48K frame): one ISR call must always fit in a frame and leave most
+// of it to the game.  The default slice of 64 takes about 1/8 of a frame
+#define BEEPER_ISR_FX_MAX_SLICE		128
+#if BEEPER_ISR_FX_SLICE > BEEPER_ISR_FX_MAX_SLICE
+  #error BEEPER_ISR_FX_SLICE must not be greater than 128!
+#endif
+
+// BeepFX block types and sizes
+#define BEEPFX_BLOCK_TONE		1
+#define BEEPFX_BLOCK_NOISE		2
+#define BEEPFX_TONE_BLOCK_SIZE		11
+#define BEEPFX_NOISE_BLOCK_SIZE		7
+
+#define BEEPER_PORT			0xfe
+#define BEEPER_EAR_BIT			0x10
+
+// BeepFX noise is generated by reading the first 8K of ROM
+#define BEEPFX_NOISE_ADDR_MASK		0x1fff
+
+// effects waiting for the current one to finish, sorted by descending priority
+struct beeper_fx_pending_s {
+    void *fx;
+    uint8_t priority;
+};
+static struct beeper_fx_pending_s beeper_fx_pending[ BEEPER_FX_QUEUE_SIZE ];
+static uint8_t beeper_fx_num_pending;
+
+// state of the effect being played; block is NULL if idle
+static struct {
+    uint8_t *block;
+    uint8_t priority;
+    uint16_t frames;
+    uint16_t frame_len;
+    uint16_t pitch;
+    uint16_t acc;
+    uint8_t duty;
+    uint8_t noise_count;
+    uint16_t noise_addr;
+} player;
+
+// sets up the player for the block pointed to by player.block, skipping
+// empty blocks and going idle at the end of the effect
+static void beeper_fx_start_block( void ) {
+    uint8_t *b;
+    while ( ( b = player.block ) ) {
+        player.frames = *( uint16_t * ) ( b + 1 );
+        player.frame_len = *( uint16_t * ) ( b + 3 );
+        if ( b[0] == BEEPFX_BLOCK_TONE ) {
+            if ( player.frames ) {
+                player.pitch = *( uint16_t * ) ( b + 5 );
+                player.duty = b[9];
+                player.acc = 0;
+                return;
+            }
+            player.block += BEEPFX_TONE_BLOCK_SIZE;
+        } else if ( b[0] == BEEPFX_BLOCK_NOISE ) {
+            if ( player.frames ) {
+                player.pitch = b[5];
+                player.noise_count = 1;
+                player.noise_addr = 0x0101;
+                return;
+            }
+            player.block += BEEPFX_NOISE_BLOCK_SIZE;
+        } else {
+            // end marker, or a block type we do not render (samples)
+            player.block = NULL;
+        }
+    }
+}
+
+static void beeper_fx_start( void *fx, uint8_t priority ) {
+    player.block = fx;
+    player.priority = priority;
+    beeper_fx_start_block();
+}
+
+// queue an effect to be played after the current one.  If the queue is
+// full, the lowest priority effect is dropped
+static void beeper_fx_queue_pending( void *fx, uint8_t priority ) {
+    uint8_t i;
+
+    if ( beeper_fx_num_pending == BEEPER_FX_QUEUE_SIZE ) {
+        if ( priority <= beeper_fx_pending[ BEEPER_FX_QUEUE_SIZE - 1 ].priority )
+            return;
+        beeper_fx_num_pending--;
+    }
+
+    // insert keeping the list sorted; equal priorities keep arrival order
+    i = beeper_fx_num_pending++;
+    while ( i && ( beeper_fx_pending[ i - 1 ].priority < priority ) ) {
+        beeper_fx_pending[ i ] = beeper_fx_pending[ i - 1 ];
+        i--;
+    }
+    beeper_fx_pending[ i ].fx = fx;
+    beeper_fx_pending[ i ].priority = priority;
+}
+
+static void beeper_fx_start_next_pending( void ) {
+    uint8_t i;
+
+    if ( ! beeper_fx_num_pending )
+        return;
+    beeper_fx_start( beeper_fx_pending[0].fx, beeper_fx_pending[0].priority );
+    beeper_fx_num_pending--;
+    for ( i = 0; i < beeper_fx_num_pending; i++ )
+        beeper_fx_pending[ i ] = beeper_fx_pending[ i + 1 ];
+}
+
+// picks up the requests queued by beeper_request_fx.  A request with the
+// same or higher priority than the current effect cuts it; otherwise it
+// waits until the current one ends
+static void beeper_fx_check_requests( void ) {
+    void *fx;
+    uint8_t priority;
+
+    while ( game_state.beeper_fx_queue_tail != game_state.beeper_fx_queue_head ) {
+        fx = game_state.beeper_fx_queue[ game_state.beeper_fx_queue_tail ];
+        game_state.beeper_fx_queue_tail = ( game_state.beeper_fx_queue_tail + 1 ) & ( BEEPER_FX_QUEUE_SIZE - 1 );
+        priority = beeper_fx_get_priority( fx );
+        if ( ( ! player.block ) || ( priority >= player.priority ) )
+            beeper_fx_start( fx, priority );
+        else
+            beeper_fx_queue_pending( fx, priority );
+    }
+}
+
+// called from the ISR: renders one frame of the current effect
+void beeper_do_periodic_tasks( void ) {
+    uint8_t n;
+    uint8_t *b;
+
+    beeper_fx_check_requests();
+    if ( ! ( b = player.block ) )
+        return;
+
+    n = ( player.frame_len > BEEPER_ISR_FX_SLICE ? BEEPER_ISR_FX_SLICE : player.frame_len );
+
+    if ( b[0] == BEEPFX_BLOCK_TONE ) {
+        // square wave: speaker is on while the high byte of the phase
+        // accumulator is below the duty value
+        while ( n-- ) {
+            player.acc += player.pitch;
+            z80_outp( BEEPER_PORT, ( ( player.acc >> 8 ) < player.duty ) ? BEEPER_EAR_BIT : 0 );
+        }
+        player.duty += b[10];
+        player.pitch += *( uint16_t * ) ( b + 7 );
+    } else {
+        // noise: a new ROM byte is sampled every 'pitch' iterations
+        while ( n-- ) {
+            if ( ! --player.noise_count ) {
+                player.noise_count = player.pitch;
+                player.noise_addr = ( player.noise_addr + 1 ) & BEEPFX_NOISE_ADDR_MASK;
+            }
+            z80_outp( BEEPER_PORT, *( uint8_t * ) player.noise_addr & BEEPER_EAR_BIT );
+        }
+        player.pitch = ( uint8_t ) ( player.pitch + b[6] );
+    }
+
+    if ( ! --player.frames ) {
+        player.block += ( b[0] == BEEPFX_BLOCK_TONE ? BEEPFX_TONE_BLOCK_SIZE : BEEPFX_NOISE_BLOCK_SIZE );
+        beeper_fx_start_block();
+        if ( ! player.block ) {
+            z80_outp( BEEPER_PORT, 0 );
+            beeper_fx_start_next_pending();
+        }
+    }
+}
+
+#endif // BUILD_FEATURE_BEEPER_ISR_FX
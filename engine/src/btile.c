@@ -9,11 +9,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <arch/spectrum.h>
+#include <string.h>
 
 #include "rage1/btile.h"
 #include "rage1/memory.h"
 #include "rage1/debug.h"
 #include "rage1/game_state.h"
+#include "rage1/screen.h"
 
 #include "game_data.h"
 
@@ -33,6 +35,59 @@
 // TT_DECORATION, TT_OBSTACLE, ...
 uint8_t screen_pos_tile_type_data[ TILE_TYPE_DATA_SIZE ];
 
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+// obstacle bitmap, kept alongside the tile type map
+uint8_t screen_obstacle_bitmap[ OBSTACLE_BITMAP_SIZE ];
+
+// bitmap masks for column ( c & 0x07 )
+uint8_t obstacle_bitmap_bit[ 8 ]		= { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+uint8_t obstacle_bitmap_first_mask[ 8 ]	= { 0xFF, 0x7F, 0x3F, 0x1F, 0x0F, 0x07, 0x03, 0x01 };
+uint8_t obstacle_bitmap_last_mask[ 8 ]	= { 0x80, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC, 0xFE, 0xFF };
+#endif
+
+// Btile cells are drawn with gfx_tile_put_noinv() and then invalidated
+// with a single rectangle per btile.  While a batch is open (e.g. when
+// drawing a full screen) the per-btile invalidation is skipped, and
+// btile_batch_end() invalidates the whole area at once
+static uint8_t btile_batch_open;
+
+void btile_batch_begin( void ) {
+    btile_batch_open = 1;
+}
+
+void btile_batch_end( gfx_rect_t *area ) __z88dk_fastcall {
+    btile_batch_open = 0;
+    gfx_invalidate_tiles( area );
+}
+
+// invalidates the cells of a btile drawn at (row,col), clipped to box
+static void btile_invalidate_clipped( uint8_t row, uint8_t col, struct btile_s *b, gfx_rect_t *box ) {
+    static gfx_rect_t r;
+    static uint8_t rmax, cmax, brmax, bcmax;
+
+    if ( btile_batch_open )
+        return;
+
+    brmax = box->row + box->height - 1;
+    bcmax = box->col + box->width - 1;
+    r.row = ( row > box->row ? row : box->row );
+    r.col = ( col > box->col ? col : box->col );
+    rmax = row + b->num_rows - 1;
+    if ( rmax > brmax )
+        rmax = brmax;
+    cmax = col + b->num_cols - 1;
+    if ( cmax > bcmax )
+        cmax = bcmax;
+
+    // the btile may be fully outside the box
+    if ( ( rmax < r.row ) || ( cmax < r.col ) )
+        return;
+
+    r.height = rmax - r.row + 1;
+    r.width = cmax - r.col + 1;
+    gfx_invalidate_tiles( &r );
+}
+
 // draw a given btile
 
 // If we are using animated btiles, we include a generic function to display
@@ -42,8 +97,62 @@ uint8_t screen_pos_tile_type_data[ TILE_TYPE_DATA_SIZE ];
 // btile_draw (the one that was used when animated btiles were not
 // implemented)
 
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS
+// draws a btile frame walking its stream of cell records.  The stream must
+// be walked for all cells, also for those outside the box
+static void btile_draw_cells( uint8_t row, uint8_t col, struct btile_s *b, uint8_t *p, uint8_t type, gfx_rect_t *box ) {
+    static uint8_t dr, dc, r, c, rmax, cmax;
+    static uint8_t brmin, brmax, bcmin, bcmax;
+    static uint8_t *tile, *arena;
+#ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
+    static uint8_t attr;
+#endif
+
+    brmin = box->row;
+    bcmin = box->col;
+    brmax = brmin + box->height - 1;
+    bcmax = bcmin + box->width - 1;
+
+    // the btile comes either from the home dataset or from the banked one
+    // (both are the same in 48K mode): use the arena of its dataset
+    arena = banked_assets->btile_arena;
+#ifdef BUILD_FEATURE_ZX_TARGET_128
+    if ( ( b >= home_assets->all_btiles ) && ( b < home_assets->all_btiles + home_assets->num_btiles ) )
+        arena = home_assets->btile_arena;
+#endif
+
+    rmax = b->num_rows;
+    cmax = b->num_cols;
+    for ( dr = 0; dr < rmax; ++dr )
+        for ( dc = 0; dc < cmax; ++dc ) {
+            tile = arena + BTILE_CELL_OFFSET( p );
+            p += BTILE_CELL_OFFSET_SIZE;
+#ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
+            attr = *p++;
+#endif
+            r = row + dr;
+            c = col + dc;
+            if ( ( r >= brmin ) && ( r <= brmax ) && ( c >= bcmin ) && ( c <= bcmax ) )  {
+#ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
+                gfx_tile_put_noinv( r, c, attr, (uint16_t)tile );
+#else
+                gfx_tile_put_noinv( r, c, game_state.default_mono_attr, (uint16_t)tile );
+#endif
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+                if ( type != TT_PRECOMPILED )
+#endif
+                SET_TILE_TYPE_AT( r, c, type );
+            }
+        }
+    btile_invalidate_clipped( row, col, b, box );
+}
+#endif // BUILD_FEATURE_BTILE_CELL_OFFSETS
+
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
 void btile_draw_frame( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_rect_t *box, uint8_t num_frame ) {
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS
+    btile_draw_cells( row, col, b, b->frames[ num_frame ].cells, type, box );
+#else
     static uint8_t dr, dc, r, c, n, rmax, cmax;
     static uint8_t brmin, brmax, bcmin, bcmax;
 
@@ -61,13 +170,18 @@ void btile_draw_frame( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type
             c = col + dc;
             if ( ( r >= brmin ) && ( r <= brmax ) && ( c >= bcmin ) && ( c <= bcmax ) )  {
 #ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
-                gfx_tile_put( r, c, b->frames[ num_frame ].attrs[ n ], (uint16_t)b->frames[ num_frame ].tiles[ n ] );
+                gfx_tile_put_noinv( r, c, b->frames[ num_frame ].attrs[ n ], (uint16_t)b->frames[ num_frame ].tiles[ n ] );
 #else
-                gfx_tile_put( r, c, game_state.default_mono_attr, (uint16_t)b->frames[ num_frame ].tiles[ n ] );
+                gfx_tile_put_noinv( r, c, game_state.default_mono_attr, (uint16_t)b->frames[ num_frame ].tiles[ n ] );
+#endif
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+                if ( type != TT_PRECOMPILED )
 #endif
                 SET_TILE_TYPE_AT( r, c, type );
             }
         }
+    btile_invalidate_clipped( row, col, b, box );
+#endif // BUILD_FEATURE_BTILE_CELL_OFFSETS
 }
 
 void btile_draw( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_rect_t *box ) {
@@ -81,18 +195,25 @@ void btile_draw( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_
 // interesting to do it, but may be it is in the future
 
 void btile_animate_all( void ) {
-    uint8_t btile_pos_id;
-    uint16_t btile_id;
-    uint8_t max_frames,num_frame;
+    uint8_t num_frame;
     struct btile_pos_s *btile_pos;
-    struct btile_s *btile;
-    struct animation_data_s *anim;
+    struct animated_btile_s *ab;
+
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+    animation_clocks_tick( btile_animation_clocks );
+#endif
 
     uint16_t i = game_state.current_screen_ptr->animated_btile_data.num_btiles;
     while ( i-- ) {
-        btile_pos_id = game_state.current_screen_ptr->animated_btile_data.btiles[ i ].btile_pos_id;
-        btile_id = game_state.current_screen_ptr->animated_btile_data.btiles[ i ].btile_id;
-        btile_pos = &game_state.current_screen_ptr->btile_data.btiles_pos[ btile_pos_id ];
+        ab = &game_state.current_screen_ptr->animated_btile_data.btiles[ i ];
+
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+        // nothing to do until the btile clock fires
+        if ( ! ANIMATION_CLOCK_FIRED( btile_animation_clocks, &ab->anim ) )
+            continue;
+#endif
+
+        btile_pos = &game_state.current_screen_ptr->btile_data.btiles_pos[ ab->btile_pos_id ];
 
         // if the btile has state and is NOT active, skip quickly
         if ( ( btile_pos->state_index != ASSET_NO_STATE ) &&
@@ -101,21 +222,38 @@ void btile_animate_all( void ) {
 
         // we animate if there is no state ( no state = always active ), or if the btile is active
 
-        anim = &game_state.current_screen_ptr->animated_btile_data.btiles[ i ].anim;
-        max_frames = dataset_get_banked_btile_ptr( btile_id )->sequences[ anim->current.sequence ].num_frames;
-
         // animation_sequence_tick returns 1 if a frame change is needed, 0 if not
-        if ( animation_sequence_tick( anim, max_frames ) ) {
-            btile = dataset_get_banked_btile_ptr( btile_id );
-            num_frame = btile->sequences[ anim->current.sequence ].frame_numbers[ anim->current.sequence_counter ];
-            btile_draw_frame( btile_pos->row, btile_pos->col, btile, btile_pos->type, &game_area, num_frame );
+        // btile and max_frames were cached by btile_animation_reset_all()
+        if ( animation_sequence_tick( &ab->anim, ab->max_frames ) ) {
+            num_frame = ab->btile->sequences[ ab->anim.current.sequence ].frame_numbers[ ab->anim.current.sequence_counter ];
+            btile_draw_frame( btile_pos->row, btile_pos->col, ab->btile, btile_pos->type, &game_area, num_frame );
         }
     }
 }
 
+// resets the animated btiles of a screen on entry, and caches their btile
+// pointer and number of frames.  The btile sequence does not change while
+// on the screen
+void btile_animation_reset_all( uint16_t num_btiles, struct animated_btile_s *btiles ) {
+    struct animated_btile_s *ab;
+
+    while ( num_btiles-- ) {
+        ab = &btiles[ num_btiles ];
+        animation_reset_state( &ab->anim );
+        ab->btile = dataset_get_banked_btile_ptr( ab->btile_id );
+        ab->max_frames = ab->btile->sequences[ ab->anim.current.sequence ].num_frames;
+    }
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+    animation_clocks_reset( btile_animation_clocks );
+#endif
+}
+
 #else // BUILD_FEATURE_ANIMATED_BTILES not defined
 
 void btile_draw( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_rect_t *box ) {
+#ifdef BUILD_FEATURE_BTILE_CELL_OFFSETS
+    btile_draw_cells( row, col, b, b->cells, type, box );
+#else
     static uint8_t dr, dc, r, c, n, rmax, cmax;
     static uint8_t brmin, brmax, bcmin, bcmax;
 
@@ -133,13 +271,18 @@ void btile_draw( uint8_t row, uint8_t col, struct btile_s *b, uint8_t type, gfx_
             c = col + dc;
             if ( ( r >= brmin ) && ( r <= brmax ) && ( c >= bcmin ) && ( c <= bcmax ) )  {
 #ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
-                gfx_tile_put( r, c, b->attrs[n], (uint16_t)b->tiles[n] );
+                gfx_tile_put_noinv( r, c, b->attrs[n], (uint16_t)b->tiles[n] );
 #else
-                gfx_tile_put( r, c, game_state.default_mono_attr, (uint16_t)b->tiles[n] );
+                gfx_tile_put_noinv( r, c, game_state.default_mono_attr, (uint16_t)b->tiles[n] );
+#endif
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+                if ( type != TT_PRECOMPILED )
 #endif
                 SET_TILE_TYPE_AT( r, c, type );
             }
         }
+    btile_invalidate_clipped( row, col, b, box );
+#endif // BUILD_FEATURE_BTILE_CELL_OFFSETS
 }
 
 #endif // BUILD_FEATURE_ANIMATED_BTILES
@@ -151,9 +294,10 @@ void btile_remove( uint8_t row, uint8_t col, struct btile_s *b ) {
     cmax = b->num_cols;
     for ( dr = 0; dr < rmax; ++dr )
         for ( dc = 0; dc < cmax; ++dc ) {
-            gfx_tile_put( row + dr, col + dc, DEFAULT_BG_ATTR, ' ' );
+            gfx_tile_put_noinv( row + dr, col + dc, DEFAULT_BG_ATTR, ' ' );
             SET_TILE_TYPE_AT( row + dr, col + dc, TT_DECORATION );
         }
+    btile_invalidate_clipped( row, col, b, &full_screen );
 }
 
 // clears tile type array
@@ -162,8 +306,36 @@ void btile_clear_type_all_screen(void) {
     while ( i-- ) screen_pos_tile_type_data[ i ] = 0;
     // When using a packed tile type map, TT_DECORATION(=0) in all 4 positions
     // When not, TT_DECORATION as well
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+    memset( screen_obstacle_bitmap, 0, OBSTACLE_BITMAP_SIZE );
+#endif
+}
+
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+// expands RLE data encoded as (count,value) byte pairs, ended by a 0 count,
+// and returns a pointer to the data after the end mark
+static uint8_t *btile_rle_expand( uint8_t *dst, uint8_t *rle ) {
+    uint8_t n;
+    while ( ( n = *rle++ ) ) {
+        memset( dst, *rle++, n );
+        dst += n;
+    }
+    return rle;
 }
 
+// loads the tile type array from a screen's precompiled map.  The map
+// covers the whole array, so no previous clearing is needed.  If the
+// obstacle bitmap is used, the precompiled bitmap follows the map in the
+// same RLE format, so it does not need to be rebuilt from the map
+void btile_load_type_map( uint8_t *rle ) __z88dk_fastcall {
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+    btile_rle_expand( screen_obstacle_bitmap, btile_rle_expand( screen_pos_tile_type_data, rle ) );
+#else
+    btile_rle_expand( screen_pos_tile_type_data, rle );
+#endif
+}
+#endif
+
 #ifdef BUILD_FEATURE_BTILE_2BIT_TYPE_MAP
     #define TYPE_MAP_BTILE_BITS 2
     #define TYPE_MAP_BTILES_PER_BYTE 4
@@ -172,15 +344,27 @@ void btile_clear_type_all_screen(void) {
 
 #ifdef BUILD_FEATURE_BTILE_2BIT_TYPE_MAP
 // Accelerated functions for getting/setting tile types
+// 8 bytes per row: no need for 16 bit math nor division
 uint8_t btile_get_tile_type( uint8_t row, uint8_t col ) {
-    uint8_t pos = ( row * 32 + col ) / TYPE_MAP_BTILES_PER_BYTE;
+    uint8_t pos = ( row << 3 ) + ( col >> 2 );
     uint8_t rot = TYPE_MAP_BTILE_BITS * ( col & TYPE_MAP_BTILE_LOW_BITS_MASK );
     return ( ( screen_pos_tile_type_data[ pos ] >> rot ) & TYPE_MAP_BTILE_LOW_BITS_MASK );
 }
 
 void btile_set_tile_type( uint8_t row, uint8_t col, uint8_t type ) {
-    uint8_t pos = ( row * 32 + col ) / TYPE_MAP_BTILES_PER_BYTE;
+    uint8_t pos = ( row << 3 ) + ( col >> 2 );
     uint8_t rot = TYPE_MAP_BTILE_BITS * ( col & TYPE_MAP_BTILE_LOW_BITS_MASK );
     screen_pos_tile_type_data[ pos ] = ( screen_pos_tile_type_data[ pos ] & ( ~( TYPE_MAP_BTILE_LOW_BITS_MASK << rot ) ) ) | ( type << rot );
 }
 #endif
+
+#ifdef BUILD_FEATURE_BTILE_OBSTACLE_BITMAP
+void btile_set_obstacle( uint8_t row, uint8_t col, uint8_t type ) {
+    uint8_t *p = &screen_obstacle_bitmap[ ( row << 2 ) + ( col >> 3 ) ];
+    if ( type == TT_OBSTACLE )
+        *p |= obstacle_bitmap_bit[ col & 0x07 ];
+    else
+        *p &= ~obstacle_bitmap_bit[ col & 0x07 ];
+}
+
+#endif
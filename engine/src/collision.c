@@ -8,6 +8,8 @@
 // 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+
 #include "rage1/collision.h"
 #include "rage1/sprite.h"
 #include "rage1/game_state.h"
@@ -30,6 +32,145 @@ uint8_t collision_check( struct position_data_s *a,struct position_data_s *b ) {
     return 1;
 }
 
+#ifdef BUILD_FEATURE_COLLISION_GRID
+
+// Uniform collision grid: the screen is divided in 4x3 buckets of 64x64
+// pixels, and each bucket has a bitmask of the active enemies that overlap
+// it.  The grid is rebuilt once per frame, and then the hero and the
+// bullets are only checked against the enemies in the buckets they overlap
+
+#define COLLISION_GRID_SHIFT	6
+#define COLLISION_GRID_COLS	4
+#define COLLISION_GRID_ROWS	3
+
+#if MAX_ENEMIES_PER_SCREEN <= 8
+typedef uint8_t collision_mask_t;
+#elif MAX_ENEMIES_PER_SCREEN <= 16
+typedef uint16_t collision_mask_t;
+#else
+typedef uint32_t collision_mask_t;
+#endif
+
+collision_mask_t collision_grid[ COLLISION_GRID_ROWS * COLLISION_GRID_COLS ];
+
+// enemies which are still active: enemies killed during this frame are
+// removed from here, so that they are not checked again
+collision_mask_t collision_grid_active_enemies;
+
+void collision_grid_build( void ) {
+    struct enemy_info_s *s;
+    collision_mask_t bit;
+    uint8_t i, n, r, c, rmax, cmin, cmax;
+
+    memset( collision_grid, 0, sizeof( collision_grid ) );
+    collision_grid_active_enemies = 0;
+
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    i = game_state.num_active_enemies;
+    while ( i-- ) {
+        n = game_state.active_enemies[ i ];
+        s = &game_state.current_screen_ptr->enemy_data.enemies[ n ];
+        bit = (collision_mask_t) 1 << n;
+#else
+    n = game_state.current_screen_ptr->enemy_data.num_enemies;
+    s = game_state.current_screen_ptr->enemy_data.enemies;
+    bit = 1;
+    for ( i = 0; i < n; i++, s++, bit <<= 1 ) {
+        if ( ! IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state ) )
+            continue;
+#endif
+        collision_grid_active_enemies |= bit;
+        cmin = s->position.x.part.integer >> COLLISION_GRID_SHIFT;
+        cmax = s->position.xmax >> COLLISION_GRID_SHIFT;
+        rmax = s->position.ymax >> COLLISION_GRID_SHIFT;
+        for ( r = s->position.y.part.integer >> COLLISION_GRID_SHIFT; r <= rmax; r++ )
+            for ( c = cmin; c <= cmax; c++ )
+                collision_grid[ r * COLLISION_GRID_COLS + c ] |= bit;
+    }
+}
+
+// returns the mask of the active enemies in the buckets overlapped by a
+// given position
+collision_mask_t collision_grid_get_candidates( struct position_data_s *p ) __z88dk_fastcall {
+    collision_mask_t m;
+    uint8_t r, c, rmax, cmin, cmax;
+
+    m = 0;
+    cmin = p->x.part.integer >> COLLISION_GRID_SHIFT;
+    cmax = p->xmax >> COLLISION_GRID_SHIFT;
+    rmax = p->ymax >> COLLISION_GRID_SHIFT;
+    for ( r = p->y.part.integer >> COLLISION_GRID_SHIFT; r <= rmax; r++ )
+        for ( c = cmin; c <= cmax; c++ )
+            m |= collision_grid[ r * COLLISION_GRID_COLS + c ];
+    return m & collision_grid_active_enemies;
+}
+
+void collision_check_hero_with_sprites(void) {
+    struct position_data_s *hero_pos;
+    collision_mask_t m;
+    uint8_t i;
+
+#ifdef BUILD_FEATURE_HERO_ADVANCED_DAMAGE_MODE
+    // return immediately if the hero is currently immune
+    if ( IS_HERO_IMMUNE( game_state.hero ) )
+        return;
+#endif
+
+    hero_pos = &game_state.hero.position;
+
+    m = collision_grid_get_candidates( hero_pos );
+    for ( i = 0; m; i++, m >>= 1 ) {
+        if ( ( m & 1 ) &&
+                collision_check( hero_pos, &game_state.current_screen_ptr->enemy_data.enemies[ i ].position ) ) {
+            hero_handle_hit();
+            return;
+        }
+    }
+}
+
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+
+void collision_check_bullets_with_sprites( void ) {
+    struct enemy_info_s *s;
+    collision_mask_t m;
+    uint8_t si,bi;
+
+    bi = BULLET_MAX_BULLETS;
+    while ( bi-- ) {
+        if ( IS_BULLET_ACTIVE( game_state.bullet.bullets[ bi ] ) ) {
+            m = collision_grid_get_candidates( &game_state.bullet.bullets[ bi ].position );
+            for ( si = 0; m; si++, m >>= 1 ) {
+                if ( ! ( m & 1 ) )
+                    continue;
+                s = &game_state.current_screen_ptr->enemy_data.enemies[ si ];
+                if ( collision_check( &game_state.bullet.bullets[ bi ].position, &s->position ) ) {
+                    // set bullet inactive and move away
+                    RESET_BULLET_FLAG( game_state.bullet.bullets[ bi ], F_BULLET_ACTIVE );
+                    game_state.bullet.active_bullets--;
+                    sprite_move_offscreen( game_state.bullet.bullets[ bi ].sprite );
+                    // set sprite inactive and move away
+                    RESET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state, F_ENEMY_ACTIVE );
+                    sprite_move_offscreen( s->sprite );
+                    collision_grid_active_enemies &= ~( (collision_mask_t) 1 << si );
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+                    enemy_active_list_remove( si );
+#endif
+                    // TO DO: increment score, etc.
+                    FLOW_MARK_DIRTY( FLOW_DEP_ENEMIES );
+                    if ( ! --game_state.enemies_alive )
+                        SET_GAME_FLAG( F_GAME_ALL_ENEMIES_KILLED );
+                    ++game_state.enemies_killed;
+                    SET_GAME_EVENT( E_ENEMY_WAS_HIT );
+                }
+            }
+        }
+    }
+}
+
+#endif // BUILD_FEATURE_HERO_HAS_WEAPON
+
+#else // BUILD_FEATURE_COLLISION_GRID
+
 void collision_check_hero_with_sprites(void) {
     struct position_data_s *hero_pos,*enemy_pos;
     struct enemy_info_s *s;
@@ -43,6 +184,17 @@ void collision_check_hero_with_sprites(void) {
 
     hero_pos = &game_state.hero.position;
 
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    i = game_state.num_active_enemies;
+    while ( i-- ) {
+        s = &game_state.current_screen_ptr->enemy_data.enemies[ game_state.active_enemies[ i ] ];
+        enemy_pos = &s->position;
+        if ( collision_check( hero_pos, enemy_pos ) ) {
+            hero_handle_hit();
+            return;
+        }
+    }
+#else
     i = game_state.current_screen_ptr->enemy_data.num_enemies;
     while ( i-- ) {
         s = &game_state.current_screen_ptr->enemy_data.enemies[ i ];
@@ -55,6 +207,7 @@ void collision_check_hero_with_sprites(void) {
             }
         }
     }
+#endif
 }
 
 #ifdef BUILD_FEATURE_HERO_HAS_WEAPON
@@ -62,28 +215,44 @@ void collision_check_hero_with_sprites(void) {
 void collision_check_bullets_with_sprites( void ) {
     struct enemy_info_s *s;
     uint8_t si,bi;
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    uint8_t ai;
+#endif
 
     bi = BULLET_MAX_BULLETS;
     while ( bi-- ) {
         if ( IS_BULLET_ACTIVE( game_state.bullet.bullets[ bi ] ) ) {
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+            // walk the list from last to first, so that killed enemies can
+            // be removed while walking it
+            ai = game_state.num_active_enemies;
+            while ( ai-- ) {
+                si = game_state.active_enemies[ ai ];
+                s = &game_state.current_screen_ptr->enemy_data.enemies[ si ];
+#else
             si = game_state.current_screen_ptr->enemy_data.num_enemies;
             while ( si-- ) {
                 s = &game_state.current_screen_ptr->enemy_data.enemies[ si ];
-                if ( IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state ) ) {
-                    if ( collision_check( &game_state.bullet.bullets[ bi ].position, &s->position ) ) {
-                        // set bullet inactive and move away
-                        RESET_BULLET_FLAG( game_state.bullet.bullets[ bi ], F_BULLET_ACTIVE );
-                        game_state.bullet.active_bullets--;
-                        sprite_move_offscreen( game_state.bullet.bullets[ bi ].sprite );
-                        // set sprite inactive and move away
-                        RESET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state, F_ENEMY_ACTIVE );
-                        sprite_move_offscreen( s->sprite );
-                        // TO DO: increment score, etc.
-                        if ( ! --game_state.enemies_alive )
-                            SET_GAME_FLAG( F_GAME_ALL_ENEMIES_KILLED );
-                        ++game_state.enemies_killed;
-                        SET_GAME_EVENT( E_ENEMY_WAS_HIT );
-                    }
+                if ( ! IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state ) )
+                    continue;
+#endif
+                if ( collision_check( &game_state.bullet.bullets[ bi ].position, &s->position ) ) {
+                    // set bullet inactive and move away
+                    RESET_BULLET_FLAG( game_state.bullet.bullets[ bi ], F_BULLET_ACTIVE );
+                    game_state.bullet.active_bullets--;
+                    sprite_move_offscreen( game_state.bullet.bullets[ bi ].sprite );
+                    // set sprite inactive and move away
+                    RESET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ s->state_index ].asset_state, F_ENEMY_ACTIVE );
+                    sprite_move_offscreen( s->sprite );
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+                    enemy_active_list_remove( si );
+#endif
+                    // TO DO: increment score, etc.
+                    FLOW_MARK_DIRTY( FLOW_DEP_ENEMIES );
+                    if ( ! --game_state.enemies_alive )
+                        SET_GAME_FLAG( F_GAME_ALL_ENEMIES_KILLED );
+                    ++game_state.enemies_killed;
+                    SET_GAME_EVENT( E_ENEMY_WAS_HIT );
                 }
             }
         }
@@ -91,3 +260,5 @@ void collision_check_bullets_with_sprites( void ) {
 }
 
 #endif // BUILD_FEATURE_HERO_HAS_WEAPON
+
+#endif // BUILD_FEATURE_COLLISION_GRID
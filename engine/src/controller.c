@@ -14,6 +14,8 @@
 #include "rage1/game_state.h"
 #include "rage1/debug.h"
 
+#include "game_data.h"
+
 /////////////////////////////////////
 //
 // Controller initialization
@@ -29,7 +31,85 @@ void init_controllers(void) {
    game_state.controller.type = 0;
 }
 
+#ifdef BUILD_FEATURE_INPUT_REPLAY
+
+// current position in the RLE stream: offset of the current pair and
+// count of repetitions of its value
+uint16_t input_replay_pos;
+uint8_t input_replay_count;
+
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+// set when the recording buffer is full
+uint8_t input_replay_finished;
+#endif
+
+void controller_input_replay_reset( void ) {
+   input_replay_pos = 0;
+   input_replay_count = 0;
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+   input_replay_finished = 0;
+#endif
+}
+
+#endif // BUILD_FEATURE_INPUT_REPLAY
+
+#ifdef BUILD_FEATURE_INPUT_REPLAY_PLAY
+
+// replay mode: the controller state comes from the prerecorded stream
 uint8_t controller_read_state(void) {
+   static uint8_t value;
+
+   // no more input when the stream is exhausted
+   if ( input_replay_pos >= INPUT_REPLAY_DATA_SIZE )
+      return 0;
+
+   value = input_replay_data[ input_replay_pos + 1 ];
+   if ( ++input_replay_count == input_replay_data[ input_replay_pos ] ) {
+      input_replay_count = 0;
+      input_replay_pos += 2;
+   }
+   return value;
+}
+
+#else // BUILD_FEATURE_INPUT_REPLAY_PLAY
+
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+uint8_t input_replay_value;
+
+void controller_input_replay_record( uint8_t state ) {
+   // nothing else is recorded once the buffer is full
+   if ( input_replay_finished )
+      return;
+
+   // same value as the current pair: just increment its count
+   if ( input_replay_count && ( state == input_replay_value ) && ( input_replay_count < 255 ) )
+      input_replay_count++;
+   else {
+      // else, start a new pair, if there is room for it
+      if ( input_replay_count )
+         input_replay_pos += 2;
+      if ( input_replay_pos + 2 > INPUT_REPLAY_RECORD_MAX_SIZE ) {
+         // buffer full: flush the pending pair with its final count and
+         // stop recording, so that it is not extended with later input
+         input_replay_pos -= 2;
+         input_replay_store( input_replay_pos, input_replay_count, input_replay_value );
+         input_replay_finished = 1;
+         return;
+      }
+      input_replay_value = state;
+      input_replay_count = 1;
+   }
+   input_replay_store( input_replay_pos, input_replay_count, input_replay_value );
+}
+#endif // BUILD_FEATURE_INPUT_REPLAY_RECORD
+
+// with input recording, the device state is read by a helper function and
+// then recorded; otherwise, this is controller_read_state()
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+static uint8_t controller_read_device_state(void) {
+#else
+uint8_t controller_read_state(void) {
+#endif
    switch ( game_state.controller.type ) {
       case CTRL_TYPE_KEYBOARD: return in_stick_keyboard( &game_state.controller.keys );
       case CTRL_TYPE_KEMPSTON: return in_stick_kempston();
@@ -38,6 +118,18 @@ uint8_t controller_read_state(void) {
    return 0;
 }
 
+#ifdef BUILD_FEATURE_INPUT_REPLAY_RECORD
+uint8_t controller_read_state(void) {
+   static uint8_t state;
+
+   state = controller_read_device_state();
+   controller_input_replay_record( state );
+   return state;
+}
+#endif
+
+#endif // BUILD_FEATURE_INPUT_REPLAY_PLAY
+
 uint8_t controller_pause_key_pressed(void) {
    return in_key_pressed( IN_KEY_SCANCODE_y );
 }
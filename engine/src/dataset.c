@@ -24,14 +24,258 @@
 // struct dataset_assets_s *banked_assets;
 // struct dataset_assets_s *home_assets;
 
+#ifdef BUILD_FEATURE_DATASET_CACHE
+// cache slots, in LRU order
+struct dataset_cache_slot_s dataset_cache_slots[ DATASET_CACHE_SIZE ];
+uint16_t dataset_cache_hits;
+uint16_t dataset_cache_misses;
+
+void init_dataset_cache( void ) {
+    uint8_t i;
+    for ( i = 0; i < DATASET_CACHE_SIZE; i++ ) {
+        dataset_cache_slots[ i ].dataset = NO_DATASET;
+        dataset_cache_slots[ i ].bank_num = dataset_cache_banks[ i ];
+    }
+}
+
+// moves slot i to the front of the LRU list and returns its bank
+uint8_t dataset_cache_use_slot( uint8_t i, uint8_t d ) {
+    static uint8_t bank;
+
+    bank = dataset_cache_slots[ i ].bank_num;
+    while ( i ) {
+        dataset_cache_slots[ i ] = dataset_cache_slots[ i - 1 ];
+        i--;
+    }
+    dataset_cache_slots[ 0 ].dataset = d;
+    dataset_cache_slots[ 0 ].bank_num = bank;
+    return bank;
+}
+#endif
+
+#ifdef BUILD_FEATURE_DATASET_PREFETCH
+// Background dataset prefetch: a dataset is decompressed into the least
+// recently used cache slot a few bytes at a time, once per game loop, so
+// that it is already in the cache when the hero enters one of its screens.
+//
+// This is a resumable version of dzx0_standard (ZX0 v2 format).  Source
+// and destination are both banked at 0xC000, so the compressed data is
+// read through a small buffer in low memory
+
+#define DATASET_PREFETCH_BUFFER_SIZE	32
+
+// decompressor states.  While there are pending bytes to copy, the state
+// is AFTER_LITERALS or AFTER_MATCH, depending on the type of copy
+#define ZX0_STATE_LITERALS		0
+#define ZX0_STATE_AFTER_LITERALS	1
+#define ZX0_STATE_LAST_OFFSET		2
+#define ZX0_STATE_NEW_OFFSET		3
+#define ZX0_STATE_AFTER_MATCH		4
+
+struct dataset_prefetch_s {
+    uint8_t	dataset;	// dataset being prefetched, NO_DATASET if none
+    uint8_t	src_bank;	// bank with the compressed dataset
+    uint8_t	dst_bank;	// cache slot bank
+    uint8_t	*src;		// next compressed chunk, in src_bank
+    uint16_t	src_remaining;	// compressed bytes not yet buffered
+    uint8_t	*dst;		// next output byte, in dst_bank
+    uint8_t	buffer[ DATASET_PREFETCH_BUFFER_SIZE ];
+    uint8_t	buffer_pos;
+    uint8_t	buffer_len;
+    uint8_t	state;
+    uint8_t	bit_mask;
+    uint8_t	bit_value;
+    uint8_t	last_byte;
+    uint8_t	backtrack;
+    uint16_t	last_offset;
+    uint16_t	length;		// pending bytes of the current copy
+};
+
+struct dataset_prefetch_s dataset_prefetch = { .dataset = NO_DATASET };
+
+// must be called with dst_bank mapped
+uint8_t dataset_prefetch_read_byte( void ) {
+    if ( dataset_prefetch.buffer_pos == dataset_prefetch.buffer_len ) {
+        dataset_prefetch.buffer_len = ( dataset_prefetch.src_remaining < DATASET_PREFETCH_BUFFER_SIZE ?
+            dataset_prefetch.src_remaining : DATASET_PREFETCH_BUFFER_SIZE );
+        memory_switch_bank( dataset_prefetch.src_bank );
+        memcpy( dataset_prefetch.buffer, dataset_prefetch.src, dataset_prefetch.buffer_len );
+        memory_switch_bank( dataset_prefetch.dst_bank );
+        dataset_prefetch.src += dataset_prefetch.buffer_len;
+        dataset_prefetch.src_remaining -= dataset_prefetch.buffer_len;
+        dataset_prefetch.buffer_pos = 0;
+    }
+    return ( dataset_prefetch.last_byte = dataset_prefetch.buffer[ dataset_prefetch.buffer_pos++ ] );
+}
+
+uint8_t dataset_prefetch_read_bit( void ) {
+    if ( dataset_prefetch.backtrack ) {
+        dataset_prefetch.backtrack = 0;
+        return ( dataset_prefetch.last_byte & 1 );
+    }
+    dataset_prefetch.bit_mask >>= 1;
+    if ( ! dataset_prefetch.bit_mask ) {
+        dataset_prefetch.bit_mask = 0x80;
+        dataset_prefetch.bit_value = dataset_prefetch_read_byte();
+    }
+    return ( dataset_prefetch.bit_value & dataset_prefetch.bit_mask ? 1 : 0 );
+}
+
+// interlaced Elias gamma code
+uint16_t dataset_prefetch_read_gamma( uint8_t inverted ) {
+    uint16_t value = 1;
+    while ( ! dataset_prefetch_read_bit() )
+        value = ( value << 1 ) | ( dataset_prefetch_read_bit() ^ inverted );
+    return value;
+}
+
+void dataset_prefetch_start( uint8_t d ) __z88dk_fastcall {
+    struct dataset_cache_slot_s *slot;
+
+    // use the least recently used slot, invalidate it until the dataset
+    // is completely decompressed
+    slot = &dataset_cache_slots[ DATASET_CACHE_SIZE - 1 ];
+    slot->dataset = NO_DATASET;
+
+    dataset_prefetch.src_bank = dataset_info[ d ].bank_num;
+    dataset_prefetch.dst_bank = slot->bank_num;
+    dataset_prefetch.src = (uint8_t *) ( 0xC000 + dataset_info[ d ].offset );
+    dataset_prefetch.src_remaining = dataset_info[ d ].size;
+    dataset_prefetch.dst = (uint8_t *) 0xC000;
+    dataset_prefetch.buffer_pos = dataset_prefetch.buffer_len = 0;
+    dataset_prefetch.state = ZX0_STATE_LITERALS;
+    dataset_prefetch.bit_mask = 0;
+    dataset_prefetch.backtrack = 0;
+    dataset_prefetch.last_offset = 1;
+    dataset_prefetch.length = 0;
+    dataset_prefetch.dataset = d;
+}
+
+void dataset_prefetch_step( void ) {
+    uint8_t previous_memory_bank;
+    uint16_t budget;
+
+    if ( dataset_prefetch.dataset == NO_DATASET )
+        return;
+
+    previous_memory_bank = memory_switch_bank( dataset_prefetch.dst_bank );
+
+    budget = DATASET_PREFETCH_BYTES_PER_STEP;
+    while ( budget ) {
+        // pending literals or match bytes
+        if ( dataset_prefetch.length ) {
+            if ( dataset_prefetch.state == ZX0_STATE_AFTER_LITERALS )
+                *dataset_prefetch.dst = dataset_prefetch_read_byte();
+            else
+                *dataset_prefetch.dst = *( dataset_prefetch.dst - dataset_prefetch.last_offset );
+            dataset_prefetch.dst++;
+            dataset_prefetch.length--;
+            budget--;
+            continue;
+        }
+
+        switch ( dataset_prefetch.state ) {
+            case ZX0_STATE_LITERALS:
+                dataset_prefetch.length = dataset_prefetch_read_gamma( 0 );
+                dataset_prefetch.state = ZX0_STATE_AFTER_LITERALS;
+                break;
+            case ZX0_STATE_AFTER_LITERALS:
+                dataset_prefetch.state = ( dataset_prefetch_read_bit() ? ZX0_STATE_NEW_OFFSET : ZX0_STATE_LAST_OFFSET );
+                break;
+            case ZX0_STATE_LAST_OFFSET:
+                dataset_prefetch.length = dataset_prefetch_read_gamma( 0 );
+                dataset_prefetch.state = ZX0_STATE_AFTER_MATCH;
+                break;
+            case ZX0_STATE_AFTER_MATCH:
+                dataset_prefetch.state = ( dataset_prefetch_read_bit() ? ZX0_STATE_NEW_OFFSET : ZX0_STATE_LITERALS );
+                break;
+            case ZX0_STATE_NEW_OFFSET:
+                dataset_prefetch.last_offset = dataset_prefetch_read_gamma( 1 );
+                if ( dataset_prefetch.last_offset == 256 ) {
+                    // end marker: the dataset is now in the cache.  The
+                    // slot is still the least recently used one (the
+                    // prefetch is aborted or finished before any other
+                    // cache use), and it stays so until dataset_activate()
+                    // really uses it: promoting it here could evict the
+                    // slot of the active dataset on the next miss
+                    dataset_cache_slots[ DATASET_CACHE_SIZE - 1 ].dataset = dataset_prefetch.dataset;
+                    dataset_prefetch.dataset = NO_DATASET;
+                    budget = 0;
+                    break;
+                }
+                dataset_prefetch.last_offset = ( dataset_prefetch.last_offset << 7 ) - ( dataset_prefetch_read_byte() >> 1 );
+                dataset_prefetch.backtrack = 1;
+                dataset_prefetch.length = dataset_prefetch_read_gamma( 0 ) + 1;
+                dataset_prefetch.state = ZX0_STATE_AFTER_MATCH;
+                break;
+        }
+    }
+
+    memory_switch_bank( previous_memory_bank );
+}
+
+// starts prefetching the most likely dataset to be needed after the given
+// screen, if it is not already active, cached or being prefetched
+void dataset_prefetch_screen_neighbours( uint8_t screen_num ) __z88dk_fastcall {
+    uint8_t i, j, d;
+
+    for ( i = 0; i < DATASET_PREFETCH_NUM_CANDIDATES; i++ ) {
+        d = screen_prefetch_datasets[ screen_num ][ i ];
+        if ( d == NO_DATASET )
+            return;
+        if ( d == dataset_prefetch.dataset )
+            return;
+        if ( d == game_state.active_dataset )
+            continue;
+        for ( j = 0; j < DATASET_CACHE_SIZE; j++ )
+            if ( dataset_cache_slots[ j ].dataset == d )
+                break;
+        if ( j < DATASET_CACHE_SIZE )
+            continue;
+        dataset_prefetch_start( d );
+        return;
+    }
+}
+#endif
+
 #ifdef BUILD_FEATURE_ZX_TARGET_128
 void dataset_activate( uint8_t d ) __z88dk_fastcall {
     uint8_t previous_memory_bank;
+#ifdef BUILD_FEATURE_DATASET_CACHE
+    uint8_t i, cache_bank;
+#endif
 
     // if the dataset is already active, do nothing
     if ( game_state.active_dataset == d )
         return;
 
+#ifdef BUILD_FEATURE_DATASET_PREFETCH
+    // if the dataset is being prefetched, finish the job so that it is
+    // found in the cache.  Else abort the prefetch, since its cache slot
+    // may be reused below
+    if ( dataset_prefetch.dataset == d ) {
+        while ( dataset_prefetch.dataset != NO_DATASET )
+            dataset_prefetch_step();
+    } else
+        dataset_prefetch.dataset = NO_DATASET;
+#endif
+
+#ifdef BUILD_FEATURE_DATASET_CACHE
+    // if the dataset is cached, just copy it from the cache bank
+    for ( i = 0; i < DATASET_CACHE_SIZE; i++ ) {
+        if ( dataset_cache_slots[ i ].dataset == d ) {
+            cache_bank = dataset_cache_use_slot( i, d );
+            previous_memory_bank = memory_switch_bank( cache_bank );
+            memcpy( (void *) BANKED_DATASET_BASE_ADDRESS, (void *) 0xC000, dataset_uncompressed_size[ d ] );
+            memory_switch_bank( previous_memory_bank );
+            dataset_cache_hits++;
+            game_state.active_dataset = d;
+            return;
+        }
+    }
+    dataset_cache_misses++;
+#endif
+
     // save previous memory bank, switch the proper memory bank for the
     // given dataset
     previous_memory_bank = memory_switch_bank( dataset_info[ d ].bank_num );
@@ -41,6 +285,13 @@ void dataset_activate( uint8_t d ) __z88dk_fastcall {
     // beware: dzx0_* arguments are (source,dest), unlike memcpy and friends!
     dzx0_standard( (void *) ( 0xC000 + dataset_info[ d ].offset ), (void *) BANKED_DATASET_BASE_ADDRESS );
 
+#ifdef BUILD_FEATURE_DATASET_CACHE
+    // store the decompressed dataset in the least recently used slot, it
+    // is still pristine at this point
+    memory_switch_bank( dataset_cache_use_slot( DATASET_CACHE_SIZE - 1, d ) );
+    memcpy( (void *) 0xC000, (void *) BANKED_DATASET_BASE_ADDRESS, dataset_uncompressed_size[ d ] );
+#endif
+
     // switch back to previous memory bank
     memory_switch_bank( previous_memory_bank );
 
@@ -65,6 +316,9 @@ void init_datasets(void) {
 #ifdef BUILD_FEATURE_ZX_TARGET_128
     // setup banked dataset; it is always at the same address
     banked_assets = (struct dataset_assets_s *) BANKED_DATASET_BASE_ADDRESS;
+#ifdef BUILD_FEATURE_DATASET_CACHE
+    init_dataset_cache();
+#endif
     // activate dataset
     dataset_activate( 0 );
 #endif
@@ -28,6 +28,12 @@ void enemy_reset_position_all( uint8_t num_enemies, struct enemy_info_s *enemies
     static struct sprite_graphic_data_s *g;
     uint8_t n;
 
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    // this is called on every screen entry, so the active enemy list is
+    // also rebuilt here
+    game_state.num_active_enemies = 0;
+#endif
+
     n = num_enemies;
     while( n-- ) {
         // we reset coordinates for all enemies, even those that are not
@@ -50,12 +56,119 @@ void enemy_reset_position_all( uint8_t num_enemies, struct enemy_info_s *enemies
         // movement
         enemies[n].movement.data.linear.dx = enemies[n].movement.data.linear.initdx;
         enemies[n].movement.data.linear.dy = enemies[n].movement.data.linear.initdy;
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+        // the screen btiles are already drawn, so the limits can be updated
+        if ( ENEMY_MOVE_HAS_BOUNCE_LIMITS( enemies[n].movement ) )
+            enemy_update_bounce_limits( &enemies[n] );
+#endif
 
         // move enemy to initial position, only if it is active
-        if ( IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) )
-            gfx_sprite_move_pixel( enemies[n].sprite, &game_area, g->frame_data.frames[0], enemies[n].position.x.part.integer, enemies[n].position.y.part.integer );
+        if ( IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) ) {
+            sprite_move_pixel( enemies[n].sprite, g, g->frame_data.frames[0], enemies[n].position.x.part.integer, enemies[n].position.y.part.integer );
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+            game_state.active_enemies[ game_state.num_active_enemies++ ] = n;
+#endif
+        }
+    }
+
+#ifdef BUILD_FEATURE_ANIMATION_CLOCKS
+    // all enemy animations have just been reset, so restart their clocks in phase
+    animation_clocks_reset( enemy_animation_clocks );
+#endif
+}
+
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+// these are the same obstacle checks that enemy_animate_and_move() does for
+// bouncing enemies, and they must be kept in sync
+static uint8_t enemy_obstacle_horiz( uint8_t x, uint8_t y, struct sprite_graphic_data_s *g ) {
+    return ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y ), PIXEL_TO_CELL_COORD( x + g->width ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y ), PIXEL_TO_CELL_COORD( x - 1 ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y + g->height - 1 ), PIXEL_TO_CELL_COORD( x + g->width ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y + g->height - 1 ), PIXEL_TO_CELL_COORD( x - 1 ) ) );
+}
+
+static uint8_t enemy_obstacle_vert( uint8_t x, uint8_t y, struct sprite_graphic_data_s *g ) {
+    return ( IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y + g->height ), PIXEL_TO_CELL_COORD( x ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y - 1 ), PIXEL_TO_CELL_COORD( x ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y + g->height ), PIXEL_TO_CELL_COORD( x + g->width - 1 ) ) ||
+        IS_OBSTACLE_AT( PIXEL_TO_CELL_COORD( y - 1 ), PIXEL_TO_CELL_COORD( x + g->width - 1 ) ) );
+}
+
+// walks the enemy from its current position in both directions of its
+// movement axis, with its own step, until the first position where it would
+// have bounced.  Those positions are the new limits.  As in datagen's
+// compute_enemy_bounce_limits, the walk is clamped to 0..255 instead of
+// wrapping around
+void enemy_update_bounce_limits( struct enemy_info_s *e ) __z88dk_fastcall {
+    static struct sprite_graphic_data_s *g;
+    static struct enemy_movement_data_s *move;
+    uint8_t x, y, p, step;
+
+    g = dataset_get_banked_sprite_ptr( e->num_graphic );
+    move = &e->movement;
+    x = e->position.x.part.integer;
+    y = e->position.y.part.integer;
+
+    if ( move->data.linear.dx ) {
+        step = ( move->data.linear.dx > 0 ? move->data.linear.dx : -move->data.linear.dx );
+        p = x;
+        do {
+            p = ( p > 255 - step ? 255 : p + step );
+        } while ( ( p < move->data.linear.limit_max ) && ( p > move->data.linear.limit_min ) && ! enemy_obstacle_horiz( p, y, g ) );
+        move->data.linear.xmax = p;
+        p = x;
+        do {
+            p = ( p < step ? 0 : p - step );
+        } while ( ( p < move->data.linear.limit_max ) && ( p > move->data.linear.limit_min ) && ! enemy_obstacle_horiz( p, y, g ) );
+        move->data.linear.xmin = p;
+    } else {
+        step = ( move->data.linear.dy > 0 ? move->data.linear.dy : -move->data.linear.dy );
+        p = y;
+        do {
+            p = ( p > 255 - step ? 255 : p + step );
+        } while ( ( p < move->data.linear.limit_max ) && ( p > move->data.linear.limit_min ) && ! enemy_obstacle_vert( x, p, g ) );
+        move->data.linear.ymax = p;
+        p = y;
+        do {
+            p = ( p < step ? 0 : p - step );
+        } while ( ( p < move->data.linear.limit_max ) && ( p > move->data.linear.limit_min ) && ! enemy_obstacle_vert( x, p, g ) );
+        move->data.linear.ymin = p;
+    }
+}
+
+void enemy_update_bounce_limits_all( void ) {
+    static struct enemy_info_s *e;
+    uint8_t n;
+
+    n = game_state.current_screen_ptr->enemy_data.num_enemies;
+    e = game_state.current_screen_ptr->enemy_data.enemies;
+    while ( n-- ) {
+        if ( ENEMY_MOVE_HAS_BOUNCE_LIMITS( e->movement ) )
+            enemy_update_bounce_limits( e );
+        e++;
+    }
+}
+#endif
+
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+void enemy_active_list_add( uint8_t n ) __z88dk_fastcall {
+    if ( game_state.num_active_enemies < MAX_ENEMIES_PER_SCREEN )
+        game_state.active_enemies[ game_state.num_active_enemies++ ] = n;
+}
+
+// the removed slot is filled with the last one in the list, so it is safe
+// to remove the current enemy while walking the list from last to first
+void enemy_active_list_remove( uint8_t n ) __z88dk_fastcall {
+    uint8_t i;
+    i = game_state.num_active_enemies;
+    while ( i-- ) {
+        if ( game_state.active_enemies[ i ] == n ) {
+            game_state.active_enemies[ i ] = game_state.active_enemies[ --game_state.num_active_enemies ];
+            return;
+        }
     }
 }
+#endif
 
 // void enemy_animate_and_move_all( void )
 // void enemy_animate_and_move_all( uint8_t num_enemies, struct enemy_info_s *enemies )
@@ -65,17 +178,25 @@ void enemy_redraw_all( uint8_t num_enemies, struct enemy_info_s *enemies ) {
     uint8_t n;
     static struct sprite_graphic_data_s *g;
 
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    uint8_t i;
+    i = game_state.num_active_enemies;
+    while( i-- ) {
+        n = game_state.active_enemies[ i ];
+        if ( ENEMY_NEEDS_REDRAW( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) ) {
+#else
     n = num_enemies;
     while( n-- ) {
         if ( IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) &&
             ( ENEMY_NEEDS_REDRAW( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state ) ) ) {
+#endif
 
             // precalc some values
             g = dataset_get_banked_sprite_ptr( enemies[n].num_graphic );
 
             // move/animate sprite into new position
             // sprite may need update either because of animation, movement, or both
-            gfx_sprite_move_pixel( enemies[n].sprite, &game_area,
+            sprite_move_pixel( enemies[n].sprite, g,
                 g->frame_data.frames[ g->sequence_data.sequences[ enemies[n].animation.current.sequence ].frame_numbers[ enemies[n].animation.current.sequence_counter ] ],
                 enemies[n].position.x.part.integer, enemies[n].position.y.part.integer );
             RESET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ enemies[n].state_index ].asset_state, F_ENEMY_NEEDS_REDRAW );
@@ -32,6 +32,8 @@
 // functions here that don't use their parameter
 #pragma disable_warning 85
 
+#ifndef BUILD_FEATURE_FLOW_COMPILED_RULES
+
 // Dispatch tables for rule checks and actions
 typedef uint8_t (*rule_check_fn_t)( struct flow_rule_check_s * ) __z88dk_fastcall;
 typedef void (*rule_action_fn_t)( struct flow_rule_action_s * ) __z88dk_fastcall;
@@ -42,11 +44,76 @@ extern rule_action_fn_t rule_action_fn[];
 // global rule table for event actions
 extern struct flow_rule_table_s game_events_rule_table;
 
+#endif // BUILD_FEATURE_FLOW_COMPILED_RULES
+
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+
+// Dirty masks for the rule tables that are run repeatedly: the game_loop
+// table for the current screen and the game events table.  The
+// enter_screen and exit_screen tables are only run when switching screens,
+// and at that moment everything is dirty anyway.
+//
+// State changes are accumulated in game_state.flow_dirty, and they are
+// folded into the per-table masks each time a table is run, so that a
+// change is seen by all tables, no matter which one runs first
+#define FLOW_DIRTY_TABLE_GAME_LOOP	0
+#define FLOW_DIRTY_TABLE_GAME_EVENTS	1
+#define FLOW_NUM_DIRTY_TABLES		2
+
+uint16_t flow_table_dirty[ FLOW_NUM_DIRTY_TABLES ] = { FLOW_DEP_ALL, FLOW_DEP_ALL };
+
+// dirty mask for the table that is currently being run
+uint16_t flow_run_dirty;
+
+// sets up flow_run_dirty for running the given table
+void flow_select_dirty_table( uint8_t table ) __z88dk_fastcall {
+    uint8_t i;
+
+    i = FLOW_NUM_DIRTY_TABLES;
+    while ( i-- )
+        flow_table_dirty[ i ] |= game_state.flow_dirty;
+    game_state.flow_dirty = 0;
+
+    // rules that can't be tracked are always dirty
+    flow_run_dirty = flow_table_dirty[ table ] | FLOW_DEP_ALWAYS;
+    flow_table_dirty[ table ] = 0;
+}
+
+#endif // BUILD_FEATURE_FLOW_DIRTY_MASKS
+
+#ifndef BUILD_FEATURE_FLOW_COMPILED_RULES
+
 // executes a complete rule table
 void run_flow_rule_table( struct flow_rule_table_s *t ) __z88dk_fastcall {
     // beware Z80 optimizations!  The rule table is an ordered list, so it
     // has to be run in order from 0 to (num_rules-1)
     uint8_t i,j;
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+    struct flow_rule_s *r;
+    for ( i = 0; i < t->num_rules; i++ ) {
+        r = t->rules[i];
+        // only evaluate the checks if something they read has changed
+        // since the last run, either before this run or during it (due to
+        // the actions of previous rules).  Otherwise, the cached result is
+        // still valid
+        if ( r->deps & ( flow_run_dirty | game_state.flow_dirty ) ) {
+            r->checks_ok = 0;
+            // run the checks in order, stop as soon as one check returns false
+            for ( j = 0; j < r->num_checks; j++ ) {
+                if ( ! rule_check_fn[ r->checks[j].type ]( &r->checks[j] ) )
+                    goto checks_done;
+            }
+            r->checks_ok = 1;
+        }
+    checks_done:
+        // if all checks were true, or there were no checks; run the actions in order
+        if ( r->checks_ok ) {
+            for ( j = 0; j < r->num_actions; j++ ) {
+                rule_action_fn[ r->actions[j].type ]( &r->actions[j] );
+            }
+        }
+    }
+#else
     for ( i = 0; i < t->num_rules; i++ ) {
         // run the checks in order, skip to next rule as soon as one check returns false
         for ( j = 0; j < t->rules[i]->num_checks; j++ ) {
@@ -60,6 +127,7 @@ void run_flow_rule_table( struct flow_rule_table_s *t ) __z88dk_fastcall {
     next_rule:
         continue;
     }
+#endif
 }
 
 // check_flow_rules: execute rules in flowgen data tables for the current
@@ -70,8 +138,17 @@ void check_flow_rules( void ) {
     // WHEN_GAME_LOOP rules
     ////////////////////////////////////////////////////////
 
-    if ( game_state.current_screen_ptr->flow_data.rule_tables.game_loop.num_rules )
+    if ( game_state.current_screen_ptr->flow_data.rule_tables.game_loop.num_rules ) {
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+        flow_select_dirty_table( FLOW_DIRTY_TABLE_GAME_LOOP );
+#endif
         run_flow_rule_table( &game_state.current_screen_ptr->flow_data.rule_tables.game_loop );
+    }
+
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+    // ENTER_SCREEN and EXIT_SCREEN tables are always fully evaluated
+    flow_run_dirty = FLOW_DEP_ALL;
+#endif
 
     ////////////////////////////////////////////////////////
     // WHEN_ENTER_SCREEN and WHEN_EXIT_SCREEN rules
@@ -103,10 +180,90 @@ void check_flow_rules( void ) {
 // check_event_rules: run the rules in game_events_rule_table
 void check_game_event_rules( void ) {
     // special case for the events rules table: only runs if game_events is != 0
-    if ( game_state.game_events )
+    if ( game_state.game_events ) {
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+        flow_select_dirty_table( FLOW_DIRTY_TABLE_GAME_EVENTS );
+#endif
         run_flow_rule_table( &game_events_rule_table );
+    }
 }
 
+#else // BUILD_FEATURE_FLOW_COMPILED_RULES
+
+// With compiled rules, DATAGEN generates a C function for each rule table
+// with the checks and actions inlined, so there is no rule data to
+// interpret here: just call the proper functions for the current screen.
+// The sequence is the same as for interpreted rules above
+void check_flow_rules( void ) {
+    static struct flow_compiled_screen_rules_s *r;
+
+    r = &all_screen_compiled_rules[ game_state.current_screen ];
+
+    // WHEN_GAME_LOOP rules
+    if ( r->game_loop )
+        r->game_loop();
+
+    // run ENTER_SCREEN rules for the initial screen at game start
+    if ( GET_GAME_FLAG( F_GAME_START ) ) {
+        if ( r->enter_screen )
+            r->enter_screen();
+    }
+
+    // run rules when switching screens
+    if ( GET_LOOP_FLAG( F_LOOP_WARP_TO_SCREEN ) ) {
+        // run EXIT_SCREEN rules for the previous screen
+        if ( r->exit_screen )
+            r->exit_screen();
+
+        // switch screen
+        // game_state.current_screen is updated here!
+        game_state_switch_to_next_screen();
+
+        // run ENTER_SCREEN rules
+        r = &all_screen_compiled_rules[ game_state.current_screen ];
+        if ( r->enter_screen )
+            r->enter_screen();
+    }
+}
+
+void check_game_event_rules( void ) {
+    // special case for the events rules table: only runs if game_events is != 0
+    if ( game_state.game_events )
+        flow_compiled_game_events_rules();
+}
+
+#endif // BUILD_FEATURE_FLOW_COMPILED_RULES
+
+// helper functions used by both interpreted and compiled rules
+
+#ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_OVER_HOTZONE
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+uint8_t flow_hero_over_hotzone( uint8_t num_hotzone ) __z88dk_fastcall {
+    // the occupancy bitmask already considers if the hotzone is active
+    return ( game_state.hotzones.over & HOTZONE_BIT( num_hotzone ) ) ? 1 : 0;
+}
+#else
+uint8_t flow_hero_over_hotzone( uint8_t num_hotzone ) __z88dk_fastcall {
+    struct hotzone_info_s *hz;
+
+    hz = &game_state.current_screen_ptr->hotzone_data.hotzones[ num_hotzone ];
+
+    // if the hotzone has a state, consider if it is active or not
+    if ( hz->state_index != ASSET_NO_STATE )
+        return ( GET_HOTZONE_FLAG( game_state.current_screen_asset_state_table_ptr[ hz->state_index ].asset_state, F_HOTZONE_ACTIVE ) &&
+            collision_check( &game_state.hero.position, &hz->position )
+            );
+    else
+        // if the hotzone does not have a state, it is always active
+        return collision_check( &game_state.hero.position, &hz->position );
+}
+#endif // BUILD_FEATURE_HOTZONE_OCCUPANCY
+#endif
+
+// check functions are not needed with compiled rules, they are inlined in
+// the generated code
+#ifndef BUILD_FEATURE_FLOW_COMPILED_RULES
+
 ////////////////////////////////////////////////////////////////////
 // rules: functions for 'check' dispatch table
 // prototype: 
@@ -217,18 +374,19 @@ uint8_t do_rule_check_item_is_owned( struct flow_rule_check_s *check ) __z88dk_f
 
 #ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_OVER_HOTZONE
 uint8_t do_rule_check_hero_over_hotzone( struct flow_rule_check_s *check ) __z88dk_fastcall {
-    struct hotzone_info_s *hz;
+    return flow_hero_over_hotzone( check->data.hotzone.num_hotzone );
+}
+#endif
 
-    hz = &game_state.current_screen_ptr->hotzone_data.hotzones[ check->data.hotzone.num_hotzone ];
+#ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_ENTERED_HOTZONE
+uint8_t do_rule_check_hero_entered_hotzone( struct flow_rule_check_s *check ) __z88dk_fastcall {
+    return ( game_state.hotzones.entered & HOTZONE_BIT( check->data.hotzone.num_hotzone ) ) ? 1 : 0;
+}
+#endif
 
-    // if the hotzone has a state, consider if it is active or not
-    if ( hz->state_index != ASSET_NO_STATE )
-        return ( GET_HOTZONE_FLAG( game_state.current_screen_asset_state_table_ptr[ hz->state_index ].asset_state, F_HOTZONE_ACTIVE ) &&
-            collision_check( &game_state.hero.position, &hz->position )
-            );
-    else
-        // if the hotzone does not have a state, it is always active
-        return collision_check( &game_state.hero.position, &hz->position );
+#ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_LEFT_HOTZONE
+uint8_t do_rule_check_hero_left_hotzone( struct flow_rule_check_s *check ) __z88dk_fastcall {
+    return ( game_state.hotzones.left & HOTZONE_BIT( check->data.hotzone.num_hotzone ) ) ? 1 : 0;
 }
 #endif
 
@@ -292,6 +450,8 @@ uint8_t do_rule_check_item_is_not_owned( struct flow_rule_check_s *check ) __z88
 }
 #endif
 
+#endif // BUILD_FEATURE_FLOW_COMPILED_RULES
+
 ////////////////////////////////////////////////////////////////////
 // rules: functions for 'action' dispatch table
 // prototype:
@@ -319,6 +479,7 @@ void do_rule_action_play_sound( struct flow_rule_action_s *action ) __z88dk_fast
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_INC_LIVES
 void do_rule_action_inc_lives( struct flow_rule_action_s *action ) __z88dk_fastcall {
     game_state.hero.health.num_lives += action->data.lives.count;
+    FLOW_MARK_DIRTY( FLOW_DEP_LIVES );
 #ifdef BUILD_FEATURE_SCREEN_AREA_LIVES_AREA
     hero_update_lives_display();
 #endif
@@ -328,6 +489,8 @@ void do_rule_action_inc_lives( struct flow_rule_action_s *action ) __z88dk_fastc
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_CALL_CUSTOM_FUNCTION
 void do_rule_action_call_custom_function( struct flow_rule_action_s *action ) __z88dk_fastcall {
     action_custom_functions[ action->data.custom.function_id ]( action->data.custom.param );
+    // we don't know what the custom function may have changed
+    FLOW_MARK_DIRTY( FLOW_DEP_ALL );
 }
 #endif
 
@@ -360,6 +523,12 @@ void do_rule_action_enable_hotzone( struct flow_rule_action_s *action ) __z88dk_
     if ( hz->state_index != ASSET_NO_STATE )
         SET_HOTZONE_FLAG( game_state.current_screen_asset_state_table_ptr[ hz->state_index ].asset_state,
             F_HOTZONE_ACTIVE );
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+    // rules run after this one must see the new occupancy
+    hotzone_occupancy_refresh();
+#else
+    FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES );
+#endif
 }
 #endif
 
@@ -372,6 +541,12 @@ void do_rule_action_disable_hotzone( struct flow_rule_action_s *action ) __z88dk
     if ( hz->state_index != ASSET_NO_STATE )
         RESET_HOTZONE_FLAG( game_state.current_screen_asset_state_table_ptr[ hz->state_index ].asset_state,
             F_HOTZONE_ACTIVE );
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+    // rules run after this one must see the new occupancy
+    hotzone_occupancy_refresh();
+#else
+    FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES );
+#endif
 }
 #endif
 
@@ -380,6 +555,9 @@ void do_rule_action_enable_btile( struct flow_rule_action_s *action ) __z88dk_fa
     struct btile_pos_s *t = &game_state.current_screen_ptr->btile_data.btiles_pos[ action->data.btile.num_btile ];
     SET_BTILE_FLAG( game_state.current_screen_asset_state_table_ptr[ t->state_index ].asset_state, F_BTILE_ACTIVE );
     btile_draw( t->row, t->col, dataset_get_banked_btile_ptr( t->btile_id ) , t->type, &game_area);
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+    enemy_update_bounce_limits_all();
+#endif
 }
 #endif
 
@@ -388,6 +566,9 @@ void do_rule_action_disable_btile( struct flow_rule_action_s *action ) __z88dk_f
     struct btile_pos_s *t = &game_state.current_screen_ptr->btile_data.btiles_pos[ action->data.btile.num_btile ];
     RESET_BTILE_FLAG( game_state.current_screen_asset_state_table_ptr[ t->state_index ].asset_state, F_BTILE_ACTIVE );
     btile_remove( t->row, t->col, dataset_get_banked_btile_ptr( t->btile_id ) );
+#ifdef BUILD_FEATURE_ENEMY_BOUNCE_LIMITS
+    enemy_update_bounce_limits_all();
+#endif
 }
 #endif
 
@@ -420,30 +601,35 @@ void do_rule_action_reset_screen_flag( struct flow_rule_action_s *action ) __z88
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_FLOW_VAR_STORE
 void do_rule_action_flow_var_store( struct flow_rule_action_s *action ) __z88dk_fastcall {
     all_flow_vars[ action->data.flow_var.var_id ] = action->data.flow_var.value;
+    FLOW_MARK_DIRTY( FLOW_DEP_FLOW_VARS );
 }
 #endif
 
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_FLOW_VAR_INC
 void do_rule_action_flow_var_inc( struct flow_rule_action_s *action ) __z88dk_fastcall {
     all_flow_vars[ action->data.flow_var.var_id ]++;
+    FLOW_MARK_DIRTY( FLOW_DEP_FLOW_VARS );
 }
 #endif
 
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_FLOW_VAR_ADD
 void do_rule_action_flow_var_add( struct flow_rule_action_s *action ) __z88dk_fastcall {
     all_flow_vars[ action->data.flow_var.var_id ] += action->data.flow_var.value;
+    FLOW_MARK_DIRTY( FLOW_DEP_FLOW_VARS );
 }
 #endif
 
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_FLOW_VAR_DEC
 void do_rule_action_flow_var_dec( struct flow_rule_action_s *action ) __z88dk_fastcall {
     all_flow_vars[ action->data.flow_var.var_id ]--;
+    FLOW_MARK_DIRTY( FLOW_DEP_FLOW_VARS );
 }
 #endif
 
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_FLOW_VAR_SUB
 void do_rule_action_flow_var_sub( struct flow_rule_action_s *action ) __z88dk_fastcall {
     all_flow_vars[ action->data.flow_var.var_id ] -= action->data.flow_var.value;
+    FLOW_MARK_DIRTY( FLOW_DEP_FLOW_VARS );
 }
 #endif
 
@@ -490,6 +676,10 @@ void do_rule_action_hero_disable_weapon( struct flow_rule_action_s *action ) __z
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_ENABLE_ENEMY
 void do_rule_action_enable_enemy( struct flow_rule_action_s *action ) __z88dk_fastcall {
     struct enemy_info_s *e = &game_state.current_screen_ptr->enemy_data.enemies[ action->data.enemy.num_enemy ];
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    if ( ! IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ e->state_index ].asset_state ) )
+        enemy_active_list_add( action->data.enemy.num_enemy );
+#endif
     SET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ e->state_index ].asset_state, F_ENEMY_ACTIVE | F_ENEMY_NEEDS_REDRAW );
 }
 #endif
@@ -497,12 +687,18 @@ void do_rule_action_enable_enemy( struct flow_rule_action_s *action ) __z88dk_fa
 #ifdef BUILD_FEATURE_FLOW_RULE_ACTION_DISABLE_ENEMY
 void do_rule_action_disable_enemy( struct flow_rule_action_s *action ) __z88dk_fastcall {
     struct enemy_info_s *e = &game_state.current_screen_ptr->enemy_data.enemies[ action->data.enemy.num_enemy ];
+#ifdef BUILD_FEATURE_ENEMY_ACTIVE_LIST
+    if ( IS_ENEMY_ACTIVE( game_state.current_screen_asset_state_table_ptr[ e->state_index ].asset_state ) )
+        enemy_active_list_remove( action->data.enemy.num_enemy );
+#endif
     RESET_ENEMY_FLAG( game_state.current_screen_asset_state_table_ptr[ e->state_index ].asset_state, F_ENEMY_ACTIVE );
     sprite_move_offscreen( e->sprite );
 }
 #endif
 
-// dispatch tables for check and action functions
+// dispatch tables for check and action functions, not needed with
+// compiled rules
+#ifndef BUILD_FEATURE_FLOW_COMPILED_RULES
 
 // Table of check functions. The 'check' value from the rule is used to
 // index into this table and execute the appropriate function
@@ -647,6 +843,16 @@ rule_check_fn_t rule_check_fn[ RULE_CHECK_MAX + 1 ] = {
 #else
     NULL,
 #endif
+#ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_ENTERED_HOTZONE
+    do_rule_check_hero_entered_hotzone,
+#else
+    NULL,
+#endif
+#ifdef BUILD_FEATURE_FLOW_RULE_CHECK_HERO_LEFT_HOTZONE
+    do_rule_check_hero_left_hotzone,
+#else
+    NULL,
+#endif
 };
 
 // Table of action functions.  The 'action' value from the rule is used to
@@ -793,3 +999,5 @@ rule_action_fn_t rule_action_fn[ RULE_ACTION_MAX + 1 ] = {
     NULL,
 #endif
 };
+
+#endif // BUILD_FEATURE_FLOW_COMPILED_RULES
@@ -32,6 +32,7 @@
 #include "rage1/codeset.h"
 #include "rage1/memory.h"
 #include "rage1/timer.h"
+#include "rage1/profiler.h"
 
 #include "game_data.h"
 
@@ -65,15 +66,23 @@ void check_loop_flags( void ) {
 
     // check if hero needs to be redrawn
     if ( GET_LOOP_FLAG( F_LOOP_REDRAW_HERO ) ) {
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+        // while a new screen is being drawn the hero is hidden, it is
+        // drawn again when the screen is complete
+        if ( ! map_draw_state.in_progress )
+#endif
         hero_draw();
         // all loop flags are reset at the beginning of the game loop
     }
 
+#ifndef BUILD_FEATURE_BEEPER_ISR_FX
     // check if sound fx needs to be played
+    // (the interrupt driven player takes its requests from the ISR)
     if ( GET_LOOP_FLAG( F_LOOP_PLAY_BEEPER_FX ) ) {
         beeper_play_pending_fx();
         // all loop flags are reset at the beginning of the game loop
     }
+#endif
 
 #ifdef BUILD_FEATURE_TRACKER_SOUNDFX
     // check if tracker sound fx needs to be played
@@ -84,12 +93,7 @@ void check_loop_flags( void ) {
 #endif
 }
 
-void move_enemies(void) {
-   RUN_ONLY_ONCE_PER_FRAME;
-
-   // move enemies
-   enemy_animate_and_move_all();
-
+void redraw_enemies(void) {
    // redraw enemies that have changed position
    enemy_redraw_all(
       game_state.current_screen_ptr->enemy_data.num_enemies, 
@@ -97,10 +101,14 @@ void move_enemies(void) {
    );
 }
 
+void move_enemies(void) {
+   // move enemies
+   enemy_animate_and_move_all();
+   redraw_enemies();
+}
+
 #ifdef BUILD_FEATURE_HERO_HAS_WEAPON
 void move_bullets(void) {
-   RUN_ONLY_ONCE_PER_FRAME;
-
    // move active shots
    bullet_animate_and_move_all();
 
@@ -113,11 +121,8 @@ void check_controller(void) {
    game_state.controller.state = controller_read_state();
 }
 
-void do_hero_actions(void) {
-    RUN_ONLY_ONCE_PER_FRAME;
-
-    hero_animate_and_move();
-
+// hero actions that are run after the hero has moved
+void do_hero_actions_after_move(void) {
 #ifdef BUILD_FEATURE_HERO_CHECK_TILES_BELOW
     hero_check_tiles_below();
 #endif
@@ -131,9 +136,15 @@ void do_hero_actions(void) {
 #endif
 }
 
-void check_collisions(void) {
-    RUN_ONLY_ONCE_PER_FRAME;
+void do_hero_actions(void) {
+    hero_animate_and_move();
+    do_hero_actions_after_move();
+}
 
+void check_collisions(void) {
+#ifdef BUILD_FEATURE_COLLISION_GRID
+    collision_grid_build();
+#endif
     collision_check_hero_with_sprites();
 #ifdef BUILD_FEATURE_HERO_HAS_WEAPON
     collision_check_bullets_with_sprites();
@@ -142,7 +153,6 @@ void check_collisions(void) {
 
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
 void animate_btiles( void ) {
-    RUN_ONLY_ONCE_PER_FRAME;
     btile_animate_all();
 }
 #endif
@@ -157,17 +167,248 @@ void show_heartbeat(void) {
 
 // this one is not needed, this task is run from the ISR
 // void run_tracker_tasks( void ) {
-//    RUN_ONLY_ONCE_PER_FRAME;
 //    tracker_do_periodic_tasks();
 //}
 
+/////////////////////////////////////
+// Game loop task scheduler
+/////////////////////////////////////
+
+// periods, phases and priorities come from game_data.h, and are set with
+// TASK directives in GAME_CONFIG
+struct game_loop_task_s game_loop_tasks[ GAME_LOOP_NUM_TASKS ] = {
+    { move_enemies, GAME_LOOP_TASK_ENEMIES_PERIOD, GAME_LOOP_TASK_ENEMIES_PHASE, GAME_LOOP_TASK_ENEMIES_PRIORITY, 0 },
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+    { move_bullets, GAME_LOOP_TASK_BULLETS_PERIOD, GAME_LOOP_TASK_BULLETS_PHASE, GAME_LOOP_TASK_BULLETS_PRIORITY, 0 },
+#endif
+    { do_hero_actions, GAME_LOOP_TASK_HERO_PERIOD, GAME_LOOP_TASK_HERO_PHASE, GAME_LOOP_TASK_HERO_PRIORITY, 0 },
+    { check_collisions, GAME_LOOP_TASK_COLLISIONS_PERIOD, GAME_LOOP_TASK_COLLISIONS_PHASE, GAME_LOOP_TASK_COLLISIONS_PRIORITY, 0 },
+#ifdef BUILD_FEATURE_ANIMATED_BTILES
+    { animate_btiles, GAME_LOOP_TASK_BTILES_PERIOD, GAME_LOOP_TASK_BTILES_PHASE, GAME_LOOP_TASK_BTILES_PRIORITY, 0 },
+#endif
+#ifdef BUILD_FEATURE_GAME_TIME
+    { timer_update_all_timers, GAME_LOOP_TASK_TIMERS_PERIOD, GAME_LOOP_TASK_TIMERS_PHASE, GAME_LOOP_TASK_TIMERS_PRIORITY, 0 },
+#endif
+#ifdef BUILD_FEATURE_GAME_LOOP_HEARTBEAT
+    { show_heartbeat, GAME_LOOP_TASK_HEARTBEAT_PERIOD, GAME_LOOP_TASK_HEARTBEAT_PHASE, GAME_LOOP_TASK_HEARTBEAT_PRIORITY, 0 },
+#endif
+};
+
+// frame counter (LSB) at the start of the current loop iteration
+uint8_t game_loop_start_tick;
+
+void game_loop_reset_tasks( void ) {
+    uint8_t i;
+    for ( i = 0; i < GAME_LOOP_NUM_TASKS; i++ ) {
+        game_loop_tasks[ i ].remaining = game_loop_tasks[ i ].phase;
+        game_loop_tasks[ i ].slipped = 0;
+    }
+    game_loop_start_tick = current_time.ticks_bytes.b0;
+}
+
+void game_loop_update_tasks( void ) {
+    uint8_t now, elapsed, i;
+
+    now = current_time.ticks_bytes.b0;
+    elapsed = now - game_loop_start_tick;
+    game_loop_start_tick = now;
+
+    // still in the same frame as the previous iteration: nothing to do
+    if ( ! elapsed )
+        return;
+
+    for ( i = 0; i < GAME_LOOP_NUM_TASKS; i++ ) {
+        if ( game_loop_tasks[ i ].remaining > elapsed )
+            game_loop_tasks[ i ].remaining -= elapsed;
+        else
+            game_loop_tasks[ i ].remaining = 0;
+    }
+}
+
+uint8_t game_loop_task_is_due( uint8_t task_id ) __z88dk_fastcall {
+    struct game_loop_task_s *t = &game_loop_tasks[ task_id ];
+
+    if ( t->remaining )
+        return 0;
+
+#ifdef GAME_LOOP_FRAME_BUDGET
+    // low priority tasks slip to the next iteration if this one has
+    // already used up its frame budget.  A slipped task runs on the next
+    // iteration unconditionally, so it is only deferred once
+    if ( ( t->priority == GAME_LOOP_TASK_PRIORITY_LOW ) && ( ! t->slipped ) &&
+            ( ( uint8_t ) ( current_time.ticks_bytes.b0 - game_loop_start_tick ) >= GAME_LOOP_FRAME_BUDGET ) ) {
+        t->slipped = 1;
+        return 0;
+    }
+    t->slipped = 0;
+#endif
+
+    t->remaining = t->period;
+    return 1;
+}
+
+void game_loop_run_task( uint8_t task_id ) __z88dk_fastcall {
+    if ( game_loop_task_is_due( task_id ) )
+        game_loop_tasks[ task_id ].run();
+}
+
+#ifdef BUILD_FEATURE_ZX_TARGET_128
+// In 128K mode, the banked movement code of the enemies and bullets tasks
+// which are due is run in a single banked section, with only one bank
+// switch, and their sprites are redrawn afterwards.  Then the controller
+// is read and the hero task is run, in the same order as in 48K mode.  The
+// time used by the banked section is accounted in the ENEMIES phase
+void game_loop_run_move_tasks( void ) {
+    uint16_t flags = 0;
+
+    if ( game_loop_task_is_due( GAME_LOOP_TASK_ENEMIES ) )
+        flags |= BANKED_SECTION_GAME_LOOP_MOVE_ENEMY_ANIMATE_AND_MOVE_ALL;
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+    if ( game_loop_task_is_due( GAME_LOOP_TASK_BULLETS ) )
+        flags |= BANKED_SECTION_GAME_LOOP_MOVE_BULLET_ANIMATE_AND_MOVE_ALL;
+#endif
+
+    PROFILER_PHASE_START();
+    if ( flags )
+        banked_section_game_loop_move( flags );
+    if ( flags & BANKED_SECTION_GAME_LOOP_MOVE_ENEMY_ANIMATE_AND_MOVE_ALL )
+        redraw_enemies();
+    PROFILER_PHASE_END( PROFILER_PHASE_ENEMIES );
+
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+    PROFILER_PHASE_START();
+    if ( flags & BANKED_SECTION_GAME_LOOP_MOVE_BULLET_ANIMATE_AND_MOVE_ALL )
+        bullet_redraw_all();
+    PROFILER_PHASE_END( PROFILER_PHASE_BULLETS );
+#endif
+
+    // read controller
+    // changes game_state
+    check_controller();
+
+    PROFILER_PHASE_START();
+    if ( game_loop_task_is_due( GAME_LOOP_TASK_HERO ) ) {
+        banked_section_game_loop_move( BANKED_SECTION_GAME_LOOP_MOVE_HERO_ANIMATE_AND_MOVE );
+        do_hero_actions_after_move();
+    }
+    PROFILER_PHASE_END( PROFILER_PHASE_HERO );
+}
+#endif
+
+// moves the enemies, bullets and hero, and checks collisions
+void game_loop_run_move_and_collision_tasks( void ) {
+#ifdef BUILD_FEATURE_ZX_TARGET_128
+   // move enemies and bullets with a single bank switch and redraw them,
+   // then read the controller and do all hero related actions
+   // changes game_state
+   game_loop_run_move_tasks();
+#else
+   // update sprites
+   // does not change game_state
+   PROFILER_PHASE_START();
+   game_loop_run_task( GAME_LOOP_TASK_ENEMIES );
+   PROFILER_PHASE_END( PROFILER_PHASE_ENEMIES );
+
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+   PROFILER_PHASE_START();
+   game_loop_run_task( GAME_LOOP_TASK_BULLETS );
+   PROFILER_PHASE_END( PROFILER_PHASE_BULLETS );
+#endif
+
+   // read controller
+   // changes game_state
+   check_controller();
+
+   // do all hero related actions: update main character position, shoot
+   // bullets if fire pressed, grab nearby items
+   // changes game_state
+   PROFILER_PHASE_START();
+   game_loop_run_task( GAME_LOOP_TASK_HERO );
+   PROFILER_PHASE_END( PROFILER_PHASE_HERO );
+#endif
+
+   // check collisions
+   // changes game_state
+   PROFILER_PHASE_START();
+   game_loop_run_task( GAME_LOOP_TASK_COLLISIONS );
+   PROFILER_PHASE_END( PROFILER_PHASE_COLLISIONS );
+}
+
+// one iteration of the game: rules, movement, collisions and loop flags.
+// The screen update and the rest of the common end of loop tasks are run
+// afterwards by the main loop
+void game_loop_run_game_tasks( void ) {
+   // reset all loop flags and game events for a clear iteration
+   RESET_ALL_LOOP_FLAGS();
+   RESET_ALL_GAME_EVENTS();
+
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+   // find out which hotzones the hero is over, once for all rules.  It
+   // may also set the hotzone events for this iteration
+   hotzone_occupancy_update();
+#endif
+
+   // check flow rules before the regular ones. We trust the user :-)
+
+   // these must be run first, because they can change the current
+   // screen, hero position, sprites, etc.
+   // changes game_state
+   PROFILER_PHASE_START();
+   check_flow_rules();
+   PROFILER_PHASE_END( PROFILER_PHASE_FLOW_RULES );
+
+   // check_hotzones removed: they are now checked with flow_rules
+
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+   // the screen may have just been switched: movement and collisions are
+   // on hold until it has been completely drawn, but the rest of the
+   // iteration must run (e.g. the loop flags set by the rules)
+   if ( ! map_draw_state.in_progress )
+#endif
+      game_loop_run_move_and_collision_tasks();
+
+   // run game events rule table
+   PROFILER_PHASE_START();
+   check_game_event_rules();
+   PROFILER_PHASE_END( PROFILER_PHASE_GAME_EVENTS );
+
+   // run user game loop function, if any
+   run_game_function_user_game_loop();
+
+
+   // Loop flags are used as a way to defer code execution until the end
+   // of the game loop.  Loop flags may be changed by enemy code, sprite
+   // code, etc.  but crucially, by flow rule code (both in flow rules
+   // and in event rules).  So this function should be called at the very
+   // end of the game loop.
+
+   // check loop flags and react to conditions.
+   // changes game state
+   PROFILER_PHASE_START();
+   check_loop_flags();
+   PROFILER_PHASE_END( PROFILER_PHASE_LOOP_FLAGS );
+
+#ifdef BUILD_FEATURE_ANIMATED_BTILES
+   PROFILER_PHASE_START();
+   game_loop_run_task( GAME_LOOP_TASK_BTILES );
+   PROFILER_PHASE_END( PROFILER_PHASE_BTILES );
+#endif
+}
+
 void run_main_game_loop(void) {
 
    // seed PRNG. It is important that this is done here, after the menu has been run
    // and the controller has been selected. This involves the human user, and so
    // introduces a random factor in the frame and seconds counter, which are then
    // used to set the initial seed of the PRNG
+#ifdef BUILD_FEATURE_INPUT_REPLAY
+   // ...except when recording or replaying input: the PRNG sequence must
+   // be the same for the same input
+   srand( INPUT_REPLAY_SEED );
+   controller_input_replay_reset();
+#else
    srand( ( current_time.sec << 8 ) | current_time.frame );
+#endif
 
    // reset game vars and setup initial state
    game_state_reset_initial();
@@ -193,83 +434,63 @@ void run_main_game_loop(void) {
    // run user game initialization, if any
    run_game_function_user_game_init();
 
+#ifdef BUILD_FEATURE_PROFILER
+   profiler_reset();
+#endif
+
+   game_loop_reset_tasks();
+
    // run main game loop
    while ( ! ( GET_GAME_FLAG( F_GAME_OVER ) || GET_GAME_FLAG( F_GAME_END ) ) ) {
 
+      // find out which tasks are due in this iteration
+      game_loop_update_tasks();
+
 #ifdef BUILD_FEATURE_GAME_TIME
       // update timers
-      timer_update_all_timers();
+      game_loop_run_task( GAME_LOOP_TASK_TIMERS );
 #endif
 
       // check if game has been paused (press 'y')
       check_game_pause();
 
-      // reset all loop flags and game events for a clear iteration
-      RESET_ALL_LOOP_FLAGS();
-      RESET_ALL_GAME_EVENTS();
-
-      // check flow rules before the regular ones. We trust the user :-)
-
-      // these must be run first, because they can change the current
-      // screen, hero position, sprites, etc.
-      // changes game_state
-      check_flow_rules();
-
-      // check_hotzones removed: they are now checked with flow_rules
-
-      // update sprites
-      // does not change game_state
-      move_enemies();
-
-#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
-      move_bullets();
+      PROFILER_LOOP_START();
+
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+      // while a new screen is being drawn incrementally, the game is on
+      // hold: only the drawing proceeds, a few btiles on each loop
+      if ( map_draw_state.in_progress ) {
+         if ( ! map_draw_screen_step() ) {
+            hero_draw();
+            game_state_switch_screen_finish();
+         }
+      } else
+         game_loop_run_game_tasks();
+#else
+      game_loop_run_game_tasks();
 #endif
 
-      // read controller
-      // changes game_state
-      check_controller();
-
-      // do all hero related actions: update main character position, shoot
-      // bullets if fire pressed, grab nearby items
-      // changes game_state
-      do_hero_actions();
-
-      // check collisions
-      // changes game_state
-      check_collisions();
-
-      // run game events rule table
-      check_game_event_rules();
-
-      // run user game loop function, if any
-      run_game_function_user_game_loop();
-
-
-      // Loop flags are used as a way to defer code execution until the end
-      // of the game loop.  Loop flags may be changed by enemy code, sprite
-      // code, etc.  but crucially, by flow rule code (both in flow rules
-      // and in event rules).  So this function should be called at the very
-      // end of the game loop.
-
-      // check loop flags and react to conditions.
-      // changes game state
-      check_loop_flags();
+      // update screen
+      PROFILER_PHASE_START();
+      gfx_update();
+      PROFILER_PHASE_END( PROFILER_PHASE_GFX_UPDATE );
 
-#ifdef BUILD_FEATURE_ANIMATED_BTILES
-      animate_btiles();
+#ifdef BUILD_FEATURE_DATASET_PREFETCH
+      // decompress a bit more of the dataset being prefetched, if any
+      dataset_prefetch_step();
 #endif
 
-      // update screen
-      gfx_update();
+      PROFILER_LOOP_END();
 
       // do not add an intrinsic_halt() here - It will waste cycles.
       // if some of these previous functions do not need to be executed
-      // continuously but e.g.  just once every frame, please use the
-      // RUN_ONLY_ONCE_PER_FRAME macro at the very beginning of the
-      // function.  See how it has been done e.g.  in move_sprites()
+      // continuously but e.g.  just once every frame, add them to the
+      // task table above and run them with game_loop_run_task()
 
+#ifdef BUILD_FEATURE_GAME_LOOP_HEARTBEAT
       // test light just to be sure we did not hang
-//      show_heartbeat();
+      game_loop_run_task( GAME_LOOP_TASK_HEARTBEAT );
+#endif
    }
 
    // end of main game loop
@@ -13,6 +13,7 @@
 #include "rage1/map.h"
 #include "rage1/game_state.h"
 #include "rage1/hero.h"
+#include "rage1/hotzone.h"
 #include "rage1/inventory.h"
 #include "rage1/controller.h"
 #include "rage1/dataset.h"
@@ -82,6 +83,10 @@ void game_state_reset_initial(void) {
 
    game_state_assets_reset_all();
 
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+   hotzone_occupancy_reset();
+#endif
+
 #ifdef BUILD_FEATURE_FLOW_VARS
    game_state_flow_vars_reset_all();
 #endif
@@ -137,10 +142,23 @@ void game_state_switch_to_next_screen(void) {
     game_state.current_screen_ptr = get_current_screen_ptr();
     game_state.current_screen_asset_state_table_ptr = get_current_screen_asset_state_table_ptr();
 
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+    // ENTER_SCREEN rules run next and may check the hotzones
+    hotzone_occupancy_reset();
+#endif
+
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+    // blank the game area and hide the hero.  The new screen is then drawn
+    // a few btiles at a time from the main loop, which holds movement
+    // until drawing is complete, and then draws the hero and calls
+    // game_state_switch_screen_finish()
+    hero_move_offscreen();
+    map_draw_screen_start( game_state.current_screen_ptr );
+#else
     // draw the hero in the new position
     hero_draw();
 
-    // draw thw new screen and reset sprites
+    // draw the new screen and reset sprites
 
     // We must also redraw the new screen now.  Later on the main loop, when
     // we return from this function, the function do_hero_actions() uses the
@@ -151,6 +169,13 @@ void game_state_switch_to_next_screen(void) {
 
     // this sequence must be the exact same as in game_loop.c, function check_loop_flags, when GAME_START
     map_draw_screen( game_state.current_screen_ptr );
+    game_state_switch_screen_finish();
+#endif // BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+}
+
+// last part of the screen switch sequence, once the new screen has been
+// drawn: reset the enemy and bullet sprites
+void game_state_switch_screen_finish( void ) {
     enemy_reset_position_all(
        game_state.current_screen_ptr->enemy_data.num_enemies,
        game_state.current_screen_ptr->enemy_data.enemies
@@ -158,7 +183,6 @@ void game_state_switch_to_next_screen(void) {
 #ifdef BUILD_FEATURE_HERO_HAS_WEAPON
     bullet_reset_all();
 #endif // BUILD_FEATURE_HERO_HAS_WEAPON
-
 }
 
 void game_state_assets_reset_all(void) {
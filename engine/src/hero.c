@@ -96,9 +96,9 @@ void hero_reset_position(void) {
     // set initial position and move it there
     hero_set_position_x( &game_state.hero, game_state.current_screen_ptr->hero_data.startup_x );
     hero_set_position_y( &game_state.hero, game_state.current_screen_ptr->hero_data.startup_y );
-    gfx_sprite_move_pixel(
+    sprite_move_pixel(
         game_state.hero.sprite,
-        &game_area,
+        &home_assets->all_sprite_graphics[ HERO_SPRITE_ID ],
         home_assets->all_sprite_graphics[ HERO_SPRITE_ID ].frame_data.frames[ HERO_SPRITE_STEADY_FRAME_DOWN ],
         game_state.hero.position.x.part.integer,
         game_state.hero.position.y.part.integer
@@ -109,11 +109,13 @@ void hero_reset_position(void) {
 void hero_set_position_x( struct hero_info_s *h, uint8_t x ) {
     h->position.x.value = 256 * x;
     h->position.xmax = h->position.x.part.integer + HERO_SPRITE_WIDTH - 1;
+    HOTZONE_OCCUPANCY_INVALIDATE();
 }
 
 void hero_set_position_y( struct hero_info_s *h, uint8_t y ) {
     h->position.y.value = 256 * y;
     h->position.ymax = h->position.y.part.integer + HERO_SPRITE_HEIGHT - 1;
+    HOTZONE_OCCUPANCY_INVALIDATE();
 }
 
 // this is initialized on startup, it is used when resetting the hero state
@@ -138,9 +140,9 @@ void hero_reset_all(void) {
 }
 
 void hero_draw( void ) {
-    gfx_sprite_move_pixel(
+    sprite_move_pixel(
         game_state.hero.sprite,
-        &game_area,
+        &home_assets->all_sprite_graphics[ HERO_SPRITE_ID ],
         game_state.hero.animation.last_frame_ptr,
         game_state.hero.position.x.part.integer,
         game_state.hero.position.y.part.integer
@@ -221,10 +223,15 @@ void hero_check_tiles_below(void) {
             tile_type = GET_TILE_TYPE_AT( r, c );
 
 #ifdef BUILD_FEATURE_INVENTORY
-            if ( tile_type == TT_ITEM ) {
+            if ( IS_TT_ITEM( tile_type ) ) {
 
                 // get item location and number
+#ifdef BUILD_FEATURE_BTILE_OBJECT_SLOTS
+                // the item index is encoded in the tile type
+                item_loc = &game_state.current_screen_ptr->item_data.items[ TT_SLOT( tile_type ) ];
+#else
                 item_loc = map_get_item_location_at_position( game_state.current_screen_ptr, r, c );
+#endif
                 item = item_loc->item_num;
 
 #ifdef BUILD_FEATURE_HERO_HAS_WEAPON
@@ -253,11 +260,17 @@ void hero_check_tiles_below(void) {
 #endif // BUILD_FEATURE_INVENTORY
 
 #ifdef BUILD_FEATURE_CRUMBS
-            if ( ( tile_type & TT_CRUMB ) == TT_CRUMB ) {
+            if ( IS_TT_CRUMB( tile_type ) ) {
 
+#ifdef BUILD_FEATURE_BTILE_OBJECT_SLOTS
+                // the crumb index is encoded in the tile type
+                crumb_loc = &game_state.current_screen_ptr->crumb_data.crumbs[ TT_SLOT( tile_type ) ];
+                crumb_type = crumb_loc->crumb_type;
+#else
                 // get crumb location and type (low nibble)
                 crumb_loc = map_get_crumb_location_at_position( game_state.current_screen_ptr, r, c );
                 crumb_type = tile_type & 0x0F;
+#endif
 
                 // do the crumb actions, but onlu if the player has all the
                 // items indicated in the inventory mask for this crumb
@@ -318,10 +331,7 @@ void hero_move_offscreen(void) {
 
 // Hero Sprites initialization function
 void hero_init_sprites(void) {
-    game_state.hero.sprite = hero_sprite = gfx_sprite_create(
-        HERO_SPRITE_HEIGHT >> 3,
-        HERO_SPRITE_WIDTH >> 3
-    );
+    game_state.hero.sprite = hero_sprite = sprite_create( &home_assets->all_sprite_graphics[ HERO_SPRITE_ID ] );
 }
 
 #ifdef BUILD_FEATURE_HERO_ADVANCED_DAMAGE_MODE
@@ -333,6 +343,7 @@ void hero_handle_hit ( void ) {
     health_amount -= game_state.hero.damage_mode.enemy_damage;
     if ( health_amount <= 0 ) {
         SET_GAME_EVENT( E_HERO_DIED );
+        FLOW_MARK_DIRTY( FLOW_DEP_LIVES );
         if ( ! --game_state.hero.health.num_lives )
             SET_GAME_FLAG( F_GAME_OVER );
         else {
@@ -379,6 +390,7 @@ void hero_do_immunity_expiration( void ) {
 // simple hit handling with default damage mode
 void hero_handle_hit ( void ) {
     SET_GAME_EVENT( E_HERO_DIED );
+    FLOW_MARK_DIRTY( FLOW_DEP_LIVES );
     if ( ! --game_state.hero.health.num_lives )
         SET_GAME_FLAG( F_GAME_OVER );
     else {
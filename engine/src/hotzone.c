@@ -11,6 +11,8 @@
 #include "rage1/hotzone.h"
 #include "rage1/util.h"
 #include "rage1/game_state.h"
+#include "rage1/collision.h"
+#include "rage1/flow.h"
 
 #include "game_data.h"
 
@@ -24,3 +26,66 @@ uint8_t hotzone_is_inside( struct hotzone_info_s *h, uint8_t x, uint8_t y ) {
     else
         return 0;
 }
+
+#ifdef BUILD_FEATURE_HOTZONE_OCCUPANCY
+// returns the bitmask of active hotzones in the current screen which the
+// hero is over
+static uint16_t hotzone_get_occupancy( void ) {
+    struct hotzone_info_s *hz;
+    uint16_t over, bit;
+    uint8_t i;
+
+    over = 0;
+    bit = 1;
+    hz = game_state.current_screen_ptr->hotzone_data.hotzones;
+    for ( i = 0; i < game_state.current_screen_ptr->hotzone_data.num_hotzones; i++ ) {
+        // if the hotzone does not have a state, it is always active
+        if ( ( ( hz->state_index == ASSET_NO_STATE ) ||
+                GET_HOTZONE_FLAG( game_state.current_screen_asset_state_table_ptr[ hz->state_index ].asset_state, F_HOTZONE_ACTIVE ) ) &&
+                collision_check( &game_state.hero.position, &hz->position ) )
+            over |= bit;
+        bit <<= 1;
+        hz++;
+    }
+    return over;
+}
+
+void hotzone_occupancy_refresh( void ) {
+    uint16_t over;
+
+    game_state.hotzones.stale = 0;
+    over = hotzone_get_occupancy();
+    if ( over == game_state.hotzones.over )
+        return;
+
+    // transitions are accumulated until the next hotzone_occupancy_update()
+    if ( over & ~game_state.hotzones.over ) {
+        game_state.hotzones.entered |= over & ~game_state.hotzones.over;
+        SET_GAME_EVENT( E_HERO_ENTERED_HOTZONE );
+    }
+    if ( game_state.hotzones.over & ~over ) {
+        game_state.hotzones.left |= game_state.hotzones.over & ~over;
+        SET_GAME_EVENT( E_HERO_LEFT_HOTZONE );
+    }
+    game_state.hotzones.over = over;
+    FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES );
+}
+
+void hotzone_occupancy_update( void ) {
+    // the transitions of the previous update have already been seen by all
+    // rule tables
+    if ( game_state.hotzones.entered | game_state.hotzones.left ) {
+        game_state.hotzones.entered = game_state.hotzones.left = 0;
+        FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES );
+    }
+    if ( game_state.hotzones.stale )
+        hotzone_occupancy_refresh();
+}
+
+void hotzone_occupancy_reset( void ) {
+    game_state.hotzones.over = hotzone_get_occupancy();
+    game_state.hotzones.entered = game_state.hotzones.left = 0;
+    game_state.hotzones.stale = 0;
+    FLOW_MARK_DIRTY( FLOW_DEP_HOTZONES );
+}
+#endif // BUILD_FEATURE_HOTZONE_OCCUPANCY
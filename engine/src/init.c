@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "features.h"
+
+#include "rage1/init.h"
+#include "rage1/memory.h"
+#include "rage1/gfx.h"
+#include "rage1/interrupts.h"
+#include "rage1/controller.h"
+#include "rage1/hero.h"
+#include "rage1/bullet.h"
+#include "rage1/sprite.h"
+#include "rage1/beeper.h"
+#include "rage1/dataset.h"
+#include "rage1/codeset.h"
+#include "rage1/charset.h"
+#include "rage1/timer.h"
+#include "rage1/tracker.h"
+
+#include "game_data.h"
+
+void init_engine(void) {
+   init_datasets();
+
+#ifdef	BUILD_FEATURE_CODESETS
+   init_codesets();
+#endif
+
+   init_controllers();
+   init_hero();
+
+#ifdef BUILD_FEATURE_HERO_HAS_WEAPON
+   init_bullets();
+#endif
+
+#ifdef BUILD_FEATURE_SPRITE_POOL
+   init_sprite_pool();
+#endif
+
+#ifdef BUILD_FEATURE_ZX_TARGET_128
+   // this one is only needed when compiling for 128
+   // for 48 mode the beepr gets initialized by regular BSS init code
+   init_beeper();
+#endif
+
+#ifdef	BUILD_FEATURE_CUSTOM_CHARSET
+   init_custom_charset();
+#endif
+
+#ifdef BUILD_FEATURE_GAME_TIME
+   init_timer();
+#endif
+#ifdef BUILD_FEATURE_TRACKER
+   init_tracker();
+#endif
+#ifdef BUILD_FEATURE_TRACKER_SOUNDFX
+   init_tracker_sound_effects();
+#endif
+}
+
+void init_program(void) {
+
+   // from this point, RAGE1 takes full control of the machine and memory
+   init_memory();
+   init_gfx();
+
+   // interrupts must be setup before the datasets are activated
+   init_interrupts();
+
+   init_engine();
+
+   // this must be called last
+   interrupt_enable_periodic_isr_tasks();
+}
@@ -22,6 +22,7 @@
 
 #include "rage1/interrupts.h"
 #include "rage1/debug.h"
+#include "rage1/beeper.h"
 #include "rage1/memory.h"
 
 #include "game_data.h"
@@ -53,6 +54,9 @@ void do_periodic_isr_tasks( void ) {
 #ifdef BUILD_FEATURE_TRACKER
    tracker_do_periodic_tasks();
 #endif
+#ifdef BUILD_FEATURE_BEEPER_ISR_FX
+   beeper_do_periodic_tasks();
+#endif
 }
 
 void interrupt_enable_periodic_isr_tasks( void ) {
@@ -24,6 +24,61 @@
 gfx_print_ctx_t title_ctx = GFX_PRINT_CTX_INIT(title_area, DEFAULT_BG_ATTR);
 #endif // BUILD_FEATURE_SCREEN_TITLES
 
+// background btiles are decorations: with a precompiled tile type map the
+// type map must not be touched when drawing them, since they are drawn
+// after the map has been loaded
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+    #define BACKGROUND_TILE_TYPE	TT_PRECOMPILED
+#else
+    #define BACKGROUND_TILE_TYPE	TT_DECORATION
+#endif
+
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+// draws the pre-rendered static layer of a screen into the game area, in a
+// single pass over the RLE grid.  Empty cells are skipped, the game area
+// has already been cleared.  Cells are not invalidated, the caller must
+// invalidate the game area afterwards
+void map_draw_static_layer( struct map_screen_s *s ) __z88dk_fastcall {
+    static uint8_t *p;
+    static uint8_t n, v, r, c, cmax, literal;
+
+    p = s->static_layer.grid;
+    r = game_area.row;
+    c = game_area.col;
+    cmax = game_area.col + game_area.width - 1;
+    while ( ( n = *p++ ) ) {
+        literal = ! ( n & 0x80 );
+        n &= 0x7F;
+        if ( ! literal ) {
+            v = *p++;
+            // fast skip over runs of empty cells
+            if ( ! v ) {
+                c += n;
+                while ( c > cmax ) {
+                    c -= game_area.width;
+                    ++r;
+                }
+                continue;
+            }
+        }
+        while ( n-- ) {
+            if ( literal )
+                v = *p++;
+            if ( v )
+#ifdef BUILD_FEATURE_GAMEAREA_COLOR_FULL
+                gfx_tile_put_noinv( r, c, s->static_layer.attrs[ v - 1 ], (uint16_t) s->static_layer.tiles[ v - 1 ] );
+#else
+                gfx_tile_put_noinv( r, c, game_state.default_mono_attr, (uint16_t) s->static_layer.tiles[ v - 1 ] );
+#endif
+            if ( ++c > cmax ) {
+                c = game_area.col;
+                ++r;
+            }
+        }
+    }
+}
+#endif // BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+
 // draw a given screen
 void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
     uint8_t i,r,c, maxr, maxc, btwidth, btheight;
@@ -34,8 +89,16 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
     // clear screen
     gfx_clear_rect( &game_area, DEFAULT_BG_ATTR, ' ', GFX_CLEAR_TILE | GFX_CLEAR_COLOUR );
 
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+    // load the btile types for the btiles without state
+    btile_load_type_map( s->tile_type_map );
+#else
     // clear btile types
     btile_clear_type_all_screen();
+#endif
+
+    // the whole game area is invalidated once, after all btiles are drawn
+    btile_batch_begin();
 
     // draw background if present
     if ( s->background_data.probability ) {
@@ -52,7 +115,7 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
             while ( c <= maxc ) {
                 // draw the btile with probability (s->background_data.probability / 255)
                 if ( (uint8_t) rand() <= s->background_data.probability )
-                    btile_draw( r, c, bt, TT_DECORATION, &s->background_data.box );
+                    btile_draw( r, c, bt, BACKGROUND_TILE_TYPE, &s->background_data.box );
                 c += btwidth;
             }
             r += btheight;
@@ -68,8 +131,18 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
     // drawn on top.  It took me more than 2 weeks to spot a bug with a
     // state btile in the wrong position, just because a bigger fixed btile
     // was being drawn on top of it!
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+    if ( s->static_layer.grid )
+        map_draw_static_layer( s );
+#endif
+
     for ( ti = 0; ti < s->btile_data.num_btiles; ti++ ) {
         t = &s->btile_data.btiles_pos[ti];
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+        // btiles without state have already been drawn in the static layer
+        if ( ( t->state_index == ASSET_NO_STATE ) && s->static_layer.grid )
+            continue;
+#endif
         // we draw if there is no state ( no state = always active ), or if the btile is active
         if ( ( t->state_index == ASSET_NO_STATE ) ||
             IS_BTILE_ACTIVE( all_screen_asset_state_tables[ s->global_screen_num ].states[ t->state_index ].asset_state ) )
@@ -78,9 +151,7 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
 
 #ifdef BUILD_FEATURE_ANIMATED_BTILES
     // reset animation sequence counters in animated btiles
-    ti = s->animated_btile_data.num_btiles;
-    while ( ti-- )
-        animation_reset_state( &s->animated_btile_data.btiles[ ti ].anim );
+    btile_animation_reset_all( s->animated_btile_data.num_btiles, s->animated_btile_data.btiles );
 #endif // BUILD_FEATURE_ANIMATED_BTILES
 
 #ifdef BUILD_FEATURE_INVENTORY
@@ -93,7 +164,7 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
             continue;
         btile_draw( it->row, it->col,
             &home_assets->all_btiles[ all_items[ it->item_num ].btile_num ],
-            TT_ITEM,
+            TT_ITEM_TYPE( i ),
             &game_area
         );
     }
@@ -109,12 +180,14 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
             continue;
         btile_draw( cr->row, cr->col,
             &home_assets->all_btiles[ all_crumb_types[ cr->crumb_type ].btile_num ],
-            TT_CRUMB | cr->crumb_type,	// crumb type is in lower nibble
+            TT_CRUMB_TYPE( i, cr->crumb_type ),
             &game_area
         );
     }
 #endif // BUILD_FEATURE_INVENTORY
 
+    btile_batch_end( &game_area );
+
 #ifdef BUILD_FEATURE_SCREEN_TITLES
     gfx_clear_rect( &title_area, DEFAULT_BG_ATTR, ' ', GFX_CLEAR_TILE | GFX_CLEAR_COLOUR );
     if ( game_state.current_screen_ptr->title ) {
@@ -125,6 +198,159 @@ void map_draw_screen(struct map_screen_s *s) __z88dk_fastcall {
 
 }
 
+#ifdef BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+struct map_draw_state_s map_draw_state;
+
+// starts drawing a screen incrementally: the game area is blanked at once,
+// and the btiles are drawn later by map_draw_screen_step(), in the same
+// order as map_draw_screen()
+void map_draw_screen_start( struct map_screen_s *s ) __z88dk_fastcall {
+    // clear screen
+    gfx_clear_rect( &game_area, DEFAULT_BG_ATTR, ' ', GFX_CLEAR_TILE | GFX_CLEAR_COLOUR );
+
+#ifdef BUILD_FEATURE_BTILE_PRECOMPILED_TYPE_MAP
+    // load the btile types for the btiles without state
+    btile_load_type_map( s->tile_type_map );
+#else
+    // clear btile types
+    btile_clear_type_all_screen();
+#endif
+
+#ifdef BUILD_FEATURE_ANIMATED_BTILES
+    // reset animation sequence counters in animated btiles
+    btile_animation_reset_all( s->animated_btile_data.num_btiles, s->animated_btile_data.btiles );
+#endif // BUILD_FEATURE_ANIMATED_BTILES
+
+#ifdef BUILD_FEATURE_SCREEN_TITLES
+    gfx_clear_rect( &title_area, DEFAULT_BG_ATTR, ' ', GFX_CLEAR_TILE | GFX_CLEAR_COLOUR );
+    if ( game_state.current_screen_ptr->title ) {
+        gfx_print_set_pos( &title_ctx, 0, 0 );
+        gfx_print_string( &title_ctx, game_state.current_screen_ptr->title );
+    }
+#endif // BUILD_FEATURE_SCREEN_TITLES
+
+    map_draw_state.screen = s;
+    map_draw_state.phase = MAP_DRAW_PHASE_BACKGROUND;
+    map_draw_state.row = s->background_data.box.row;
+    map_draw_state.col = s->background_data.box.col;
+    map_draw_state.index = 0;
+    map_draw_state.in_progress = 1;
+}
+
+// draws the next MAP_DRAW_BTILES_PER_STEP btiles of the screen. Returns 1
+// if there is still work to do, 0 if the screen is complete
+uint8_t map_draw_screen_step( void ) {
+    static uint8_t budget;
+    struct map_screen_s *s;
+    struct btile_pos_s *t;
+    struct btile_s *bt;
+
+    s = map_draw_state.screen;
+    budget = MAP_DRAW_BTILES_PER_STEP;
+    while ( budget ) {
+        switch ( map_draw_state.phase ) {
+
+            case MAP_DRAW_PHASE_BACKGROUND:
+                if ( ( ! s->background_data.probability ) ||
+                        ( map_draw_state.row > s->background_data.box.row + s->background_data.box.height - 1 ) ) {
+                    map_draw_state.phase = MAP_DRAW_PHASE_BTILES;
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+                    // the static layer is drawn in one go, and uses up
+                    // the whole step
+                    if ( s->static_layer.grid ) {
+                        map_draw_static_layer( s );
+                        gfx_invalidate_tiles( &game_area );
+                        budget = 0;
+                    }
+#endif
+                    break;
+                }
+                bt = dataset_get_banked_btile_ptr( s->background_data.btile_num );
+                // draw the btile with probability (s->background_data.probability / 255)
+                if ( (uint8_t) rand() <= s->background_data.probability ) {
+                    btile_draw( map_draw_state.row, map_draw_state.col, bt, BACKGROUND_TILE_TYPE, &s->background_data.box );
+                    budget--;
+                }
+                map_draw_state.col += bt->num_cols;
+                if ( map_draw_state.col > s->background_data.box.col + s->background_data.box.width - 1 ) {
+                    map_draw_state.col = s->background_data.box.col;
+                    map_draw_state.row += bt->num_rows;
+                }
+                break;
+
+            case MAP_DRAW_PHASE_BTILES:
+                if ( map_draw_state.index == s->btile_data.num_btiles ) {
+                    map_draw_state.phase = MAP_DRAW_PHASE_ITEMS;
+#ifdef BUILD_FEATURE_INVENTORY
+                    map_draw_state.index = s->item_data.num_items;
+#endif
+                    break;
+                }
+                t = &s->btile_data.btiles_pos[ map_draw_state.index++ ];
+#ifdef BUILD_FEATURE_MAP_PRERENDERED_SCREENS
+                // btiles without state have already been drawn in the static layer
+                if ( ( t->state_index == ASSET_NO_STATE ) && s->static_layer.grid )
+                    break;
+#endif
+                // we draw if there is no state ( no state = always active ), or if the btile is active
+                if ( ( t->state_index == ASSET_NO_STATE ) ||
+                    IS_BTILE_ACTIVE( all_screen_asset_state_tables[ s->global_screen_num ].states[ t->state_index ].asset_state ) ) {
+                    btile_draw( t->row, t->col, dataset_get_banked_btile_ptr( t->btile_id ), t->type, &game_area );
+                    budget--;
+                }
+                break;
+
+            case MAP_DRAW_PHASE_ITEMS:
+#ifdef BUILD_FEATURE_INVENTORY
+                // items and crumbs are drawn last to first, index counts down
+                if ( map_draw_state.index ) {
+                    struct item_location_s *it;
+                    it = &s->item_data.items[ --map_draw_state.index ];
+                    if ( IS_ITEM_ACTIVE( all_items[ it->item_num ] ) ) {
+                        btile_draw( it->row, it->col,
+                            &home_assets->all_btiles[ all_items[ it->item_num ].btile_num ],
+                            TT_ITEM_TYPE( map_draw_state.index ),
+                            &game_area
+                        );
+                        budget--;
+                    }
+                    break;
+                }
+#endif // BUILD_FEATURE_INVENTORY
+                map_draw_state.phase = MAP_DRAW_PHASE_CRUMBS;
+#ifdef BUILD_FEATURE_CRUMBS
+                map_draw_state.index = s->crumb_data.num_crumbs;
+#endif
+                break;
+
+            case MAP_DRAW_PHASE_CRUMBS:
+#ifdef BUILD_FEATURE_CRUMBS
+                if ( map_draw_state.index ) {
+                    struct crumb_location_s *cr;
+                    cr = &s->crumb_data.crumbs[ --map_draw_state.index ];
+                    if ( IS_CRUMB_ACTIVE( game_state.current_screen_asset_state_table_ptr[ cr->state_index ].asset_state ) ) {
+                        btile_draw( cr->row, cr->col,
+                            &home_assets->all_btiles[ all_crumb_types[ cr->crumb_type ].btile_num ],
+                            TT_CRUMB_TYPE( map_draw_state.index, cr->crumb_type ),
+                            &game_area
+                        );
+                        budget--;
+                    }
+                    break;
+                }
+#endif // BUILD_FEATURE_CRUMBS
+                map_draw_state.phase = MAP_DRAW_PHASE_DONE;
+                break;
+
+            default:
+                map_draw_state.in_progress = 0;
+                return 0;
+        }
+    }
+    return 1;
+}
+#endif // BUILD_FEATURE_MAP_INCREMENTAL_DRAW
+
 #ifdef BUILD_FEATURE_INVENTORY
 struct item_location_s *map_get_item_location_at_position( struct map_screen_s *s, uint8_t row, uint8_t col ) {
     uint8_t i, rmax, cmax;
@@ -173,8 +399,19 @@ void map_enter_screen( uint8_t screen_num ) __z88dk_fastcall {
     dataset_activate( screen_dataset_map[ screen_num ].dataset_num );
 #endif
 
+#ifdef BUILD_FEATURE_DATASET_PREFETCH
+    // start decompressing in the background the dataset that will most
+    // probably be needed next
+    dataset_prefetch_screen_neighbours( screen_num );
+#endif
+
     // we must use the local screen number when indexing on banked_assets->all_screens!
     map_allocate_sprites( &banked_assets->all_screens[ screen_dataset_map[ screen_num ].dataset_local_screen_num ] );
+
+#ifdef BUILD_FEATURE_FLOW_DIRTY_MASKS
+    // new screen, new rule tables: all rules must be evaluated again
+    FLOW_MARK_DIRTY( FLOW_DEP_ALL );
+#endif
 }
 
 void map_exit_screen( struct map_screen_s *s ) __z88dk_fastcall {
@@ -189,10 +426,11 @@ void map_allocate_sprites( struct map_screen_s *m ) __z88dk_fastcall {
     i = m->enemy_data.num_enemies;
     while ( i-- ) {
         g = dataset_get_banked_sprite_ptr( m->enemy_data.enemies[ i ].num_graphic );
-        s = gfx_sprite_create(
-            g->height >> 3,
-            g->width >> 3
-        );
+#ifdef BUILD_FEATURE_SPRITE_POOL
+        s = sprite_pool_get( g );
+#else
+        s = sprite_create( g );
+#endif
         gfx_sprite_set_color( s, m->enemy_data.enemies[ i ].color );
         m->enemy_data.enemies[ i ].sprite = s;
     }
@@ -204,6 +442,13 @@ void map_allocate_sprites( struct map_screen_s *m ) __z88dk_fastcall {
 void map_free_sprites( struct map_screen_s *s ) __z88dk_fastcall {
     uint8_t i;
     i = s->enemy_data.num_enemies;
+#ifdef BUILD_FEATURE_SPRITE_POOL
+    // pooled sprites are not destroyed, just hidden until they are reused
+    while ( i-- )
+        sprite_move_offscreen( s->enemy_data.enemies[ i ].sprite );
+    sprite_pool_release_all();
+#else
     while ( i-- )
         gfx_sprite_destroy( s->enemy_data.enemies[ i ].sprite );
+#endif
 }
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "features.h"
+
+#include "rage1/profiler.h"
+#include "rage1/interrupts.h"
+
+#ifdef BUILD_FEATURE_PROFILER
+
+void profiler_reset( void ) {
+    static uint8_t i;
+
+    profiler_data.loop_overruns = 0;
+    memset( profiler_data.phases, 0, sizeof( profiler_data.phases ) );
+    for ( i = 0; i < PROFILER_NUM_PHASES; i++ )
+        profiler_data.phases[ i ].min = 0xff;
+}
+
+void profiler_update_stats( struct profiler_phase_stats_s *p, uint8_t elapsed ) {
+    if ( elapsed < p->min )
+        p->min = elapsed;
+    if ( elapsed > p->max )
+        p->max = elapsed;
+    p->count++;
+    p->total += elapsed;
+}
+
+void profiler_phase_end( uint8_t phase ) __z88dk_fastcall {
+    profiler_update_stats( &profiler_data.phases[ phase ],
+        current_time.ticks_bytes.b0 - profiler_data.phase_start );
+}
+
+void profiler_loop_end( void ) {
+    static uint8_t elapsed;
+
+    elapsed = current_time.ticks_bytes.b0 - profiler_data.loop_start;
+    profiler_update_stats( &profiler_data.phases[ PROFILER_PHASE_LOOP ], elapsed );
+
+    // the loop can span one tick without losing any frame; if more ticks
+    // have happened, the loop has overrun the frame
+    if ( elapsed > 1 )
+        profiler_data.loop_overruns += elapsed - 1;
+}
+
+#endif // BUILD_FEATURE_PROFILER
@@ -8,6 +8,8 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+
 #include "rage1/gfx.h"
 #include "rage1/game_state.h"
 #include "rage1/sprite.h"
@@ -34,6 +36,31 @@ static void sprite_set_cell_attributes( uint16_t count, struct sp1_cs *c ) {
     c->attr_mask	= sprite_attr_param.attr_mask;
 }
 
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+// Pre-shifted sprites have cols+1 columns of real graphic data, since the
+// shifted copies of each frame spill into the extra column.  They are
+// always moved to x positions multiple of 8, so the last column must be
+// drawn even with no rotation: xthresh is 0
+gfx_sprite_t *gfx_sprite_create_preshifted( uint8_t rows, uint8_t cols ) {
+    uint8_t c;
+    gfx_sprite_t *s;
+
+    // create the sprite and first column
+    s = sp1_CreateSpr(SP1_DRAW_MASK2LB, SP1_TYPE_2BYTE, rows + 1, 0, 0);
+    // ensure s is not NULL
+    DEBUG_ASSERT( s, PANIC_SPRITE_IS_NULL );
+
+    // add all remaining columns, including the extra one
+    for ( c = 1; c <= cols; c++ )
+        sp1_AddColSpr(s, SP1_DRAW_MASK2, 0, ( rows + 1 ) * 16 * c, 0);
+
+    gfx_sprite_set_threshold( s, 0, 1 );
+
+    // return the sprite
+    return s;
+}
+#endif
+
 gfx_sprite_t *gfx_sprite_create( uint8_t rows, uint8_t cols ) {
     uint8_t c;
     gfx_sprite_t *s;
@@ -73,6 +100,84 @@ void gfx_sprite_set_color( gfx_sprite_t *s, uint8_t color ) {
 
 #endif // BUILD_FEATURE_SPRITE_ENGINE_SP1
 
+gfx_sprite_t *sprite_create( struct sprite_graphic_data_s *g ) __z88dk_fastcall {
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+    if ( g->preshift_bits )
+        return gfx_sprite_create_preshifted( g->height >> 3, g->width >> 3 );
+#endif
+    return gfx_sprite_create( g->height >> 3, g->width >> 3 );
+}
+
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+void sprite_move_pixel( gfx_sprite_t *s, struct sprite_graphic_data_s *g, uint8_t *frame, uint8_t x, uint8_t y ) {
+    uint8_t k;
+
+    // select the copy shifted by the pixels that would otherwise be
+    // rotated; frame may be NULL when only moving the sprite
+    if ( g->preshift_bits ) {
+        if ( frame ) {
+            k = ( x & 0x07 ) >> ( 3 - g->preshift_bits );
+            while ( k-- )
+                frame += g->preshift_stride;
+        }
+        x &= 0xf8;
+    }
+    gfx_sprite_move_pixel( s, &game_area, frame, x, y );
+}
+#endif
+
+#ifdef BUILD_FEATURE_SPRITE_POOL
+
+gfx_sprite_t *sprite_pool[ SPRITE_POOL_SIZE ];
+
+// number of sprites in use for each class
+uint8_t sprite_pool_used[ SPRITE_POOL_NUM_CLASSES ];
+
+void init_sprite_pool( void ) {
+    uint8_t i, j;
+    struct sprite_pool_class_s *c;
+
+    for ( i = 0; i < SPRITE_POOL_NUM_CLASSES; i++ ) {
+        c = &sprite_pool_classes[ i ];
+        for ( j = 0; j < c->num_sprites; j++ )
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+            sprite_pool[ c->first + j ] = ( c->preshifted ?
+                gfx_sprite_create_preshifted( c->rows, c->cols ) :
+                gfx_sprite_create( c->rows, c->cols ) );
+#else
+            sprite_pool[ c->first + j ] = gfx_sprite_create( c->rows, c->cols );
+#endif
+    }
+}
+
+gfx_sprite_t *sprite_pool_get( struct sprite_graphic_data_s *g ) __z88dk_fastcall {
+    uint8_t i, rows, cols;
+    struct sprite_pool_class_s *c;
+
+    rows = g->height >> 3;
+    cols = g->width >> 3;
+    for ( i = 0; i < SPRITE_POOL_NUM_CLASSES; i++ ) {
+        c = &sprite_pool_classes[ i ];
+#ifdef BUILD_FEATURE_SPRITE_PRESHIFTED
+        if ( ( c->preshifted != ( g->preshift_bits != 0 ) ) )
+            continue;
+#endif
+        if ( ( c->rows == rows ) && ( c->cols == cols ) ) {
+            // the pool is sized for the worst screen, it can not run out
+            DEBUG_ASSERT( sprite_pool_used[ i ] < c->num_sprites, PANIC_SPRITE_IS_NULL );
+            return sprite_pool[ c->first + sprite_pool_used[ i ]++ ];
+        }
+    }
+    DEBUG_ASSERT( 0, PANIC_SPRITE_IS_NULL );
+    return NULL;
+}
+
+void sprite_pool_release_all( void ) {
+    memset( sprite_pool_used, 0, sizeof( sprite_pool_used ) );
+}
+
+#endif // BUILD_FEATURE_SPRITE_POOL
+
 void sprite_free( gfx_sprite_t *s ) __z88dk_fastcall {
     gfx_sprite_destroy( s );
 }
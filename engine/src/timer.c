@@ -35,6 +35,7 @@ void timer_update_all_timers( void ) {
         last_sec = current_time.sec;
         // update main game timer
         game_state.game_time++;
+        FLOW_MARK_DIRTY( FLOW_DEP_GAME_TIME );
         // user timers will be incremented here when they exist
     }
 }
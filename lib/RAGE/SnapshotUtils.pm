@@ -0,0 +1,102 @@
+#!/usr/bin/env perl
+
+################################################################################
+##
+## RAGE1 - Retro Adventure Game Engine, release 1
+## (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+## 
+## This code is published under a GNU GPL license version 3 or later.  See
+## LICENSE file in the distribution for details.
+## 
+################################################################################
+
+use Compress::Zlib;
+
+# 16K RAM pages which are mapped at $4000, $8000 and $C000 at startup
+my %snapshot_page_address = ( 5 => 0x4000, 2 => 0x8000, 0 => 0xC000 );
+
+# reads a SZX, SNA or raw memory dump file (64 KB from $0000, or 48 KB from
+# $4000) and returns the RAM pages in it
+# returns: hashref page_number => 16K of data
+sub snapshot_read_ram_pages {
+    my $file = shift;
+
+    open my $fh, "<:raw", $file or
+        die "** Error: could not open $file for reading\n";
+    my $data = do { local $/; <$fh> };
+    close $fh;
+
+    my $size = length( $data );
+    my %pages;
+
+    # SZX snapshot: a sequence of chunks; the RAMP chunks contain the RAM pages
+    if ( substr( $data, 0, 4 ) eq 'ZXST' ) {
+        my $pos = 8;
+        while ( $pos + 8 <= $size ) {
+            my ( $id, $chunk_size ) = unpack( 'a4V', substr( $data, $pos, 8 ) );
+            if ( $id eq 'RAMP' ) {
+                my ( $flags, $page ) = unpack( 'vC', substr( $data, $pos + 8, 3 ) );
+                my $page_data = substr( $data, $pos + 11, $chunk_size - 3 );
+                if ( $flags & 1 ) {
+                    $page_data = uncompress( $page_data );
+                    defined( $page_data ) or
+                        die "** Error: could not uncompress RAM page $page\n";
+                }
+                $pages{ $page } = $page_data;
+            }
+            $pos += 8 + $chunk_size;
+        }
+        return \%pages;
+    }
+
+    # SNA snapshot: 27 byte header + 48K RAM, and for 128K models, 4 more
+    # bytes and the remaining RAM pages in ascending order
+    if ( $file =~ /\.sna$/i ) {
+        if ( $size == 49179 ) {
+            foreach my $page ( keys %snapshot_page_address ) {
+                $pages{ $page } = substr( $data, 27 + $snapshot_page_address{ $page } - 0x4000, 0x4000 );
+            }
+            return \%pages;
+        }
+        if ( ( $size == 131103 ) or ( $size == 147487 ) ) {
+            my $paged = unpack( 'C', substr( $data, 27 + 0xC000 + 2, 1 ) ) & 0x07;
+            $pages{5} = substr( $data, 27, 0x4000 );
+            $pages{2} = substr( $data, 27 + 0x4000, 0x4000 );
+            $pages{ $paged } = substr( $data, 27 + 0x8000, 0x4000 );
+            my $pos = 27 + 0xC000 + 4;
+            foreach my $page ( grep { not defined( $pages{ $_ } ) } ( 0 .. 7 ) ) {
+                last if $pos + 0x4000 > $size;
+                $pages{ $page } = substr( $data, $pos, 0x4000 );
+                $pos += 0x4000;
+            }
+            return \%pages;
+        }
+        die "** Error: invalid SNA file size: $size\n";
+    }
+
+    # raw memory dumps
+    if ( ( $size == 65536 ) or ( $size == 49152 ) ) {
+        my $base = 65536 - $size;
+        foreach my $page ( keys %snapshot_page_address ) {
+            $pages{ $page } = substr( $data, $snapshot_page_address{ $page } - $base, 0x4000 );
+        }
+        return \%pages;
+    }
+
+    die "** Error: unknown file format for $file\n";
+}
+
+# returns a 64K string with the memory contents as seen by the Z80 at
+# startup, from the RAM pages returned by snapshot_read_ram_pages (ROM and
+# unknown areas are zero-filled)
+sub snapshot_memory_image {
+    my $pages = shift;
+    my $memory = "\x00" x 65536;
+    foreach my $page ( keys %snapshot_page_address ) {
+        substr( $memory, $snapshot_page_address{ $page }, 0x4000, $pages->{ $page } )
+            if defined( $pages->{ $page } );
+    }
+    return $memory;
+}
+
+1;
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "features.h"
+
+#include "rage1/init.h"
+#include "rage1/memory.h"
+#include "rage1/gfx.h"
+#include "rage1/map.h"
+#include "rage1/enemy.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+void bench_init( void ) {
+    // same as init_program(), but interrupts are not setup: there are no
+    // interrupts under z88dk-ticks, and we don't want them to interfere
+    // with the measurements anyway
+    init_memory();
+    init_gfx();
+    init_engine();
+
+    // setup the initial screen, as when starting the game loop
+    game_state_reset_initial();
+    map_draw_screen( game_state.current_screen_ptr );
+    enemy_reset_position_all(
+        game_state.current_screen_ptr->enemy_data.num_enemies,
+        game_state.current_screen_ptr->enemy_data.enemies
+    );
+}
+
+void bench_start( void ) {
+}
+
+void bench_end( void ) {
+}
+
+void bench_halt( void ) {
+    while ( 1 )
+        ;
+}
@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+
+#include "features.h"
+
+// Common harness for the micro-benchmarks.  Each benchmark program calls
+// bench_init(), prepares its data, and then runs BENCH_ITERATIONS calls to
+// the function being measured between bench_start() and bench_end().  The
+// bench.pl runner counts the T-states between those two addresses with
+// z88dk-ticks.  BENCH_ITERATIONS must be #defined in each benchmark source
+// file with a plain number, since bench.pl reads it from there
+
+// initializes the engine and enters the initial screen of the bench game,
+// without enabling interrupts
+void bench_init( void );
+
+// start/end markers - they must not be inlined
+void bench_start( void );
+void bench_end( void );
+
+// stops the program after the benchmark
+void bench_halt( void );
+
+#endif // _BENCH_H
@@ -0,0 +1,180 @@
+#!/usr/bin/env perl
+################################################################################
+##
+## RAGE1 - Retro Adventure Game Engine, release 1
+## (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+## 
+## This code is published under a GNU GPL license version 3 or later.  See
+## LICENSE file in the distribution for details.
+## 
+################################################################################
+
+# Micro-benchmark runner: runs each benchmark binary under z88dk-ticks,
+# counting the T-states spent between the bench_start and bench_end
+# markers, and outputs a table with the T-states per call of each
+# benchmark.  See README.md in this directory.
+#
+# usage: bench.pl [-o <results_file>] <bench_xxx.bin>...
+#        bench.pl -z <header_file>
+#
+# With -z, generates the compressed data fixture for bench_dzx0_standard.c
+
+use strict;
+use warnings;
+use utf8;
+
+use Getopt::Std;
+use File::Basename;
+
+my $ticks = $ENV{'Z88DK_TICKS'} || 'z88dk-ticks';
+my $zx0 = $ENV{'Z88DK_ZX0'} || 'z88dk-zx0';
+my $default_org = 0x5F00;	# see zpragma-48.inc
+my $zx0_data_size = 4096;
+
+our ( $opt_o, $opt_z );
+getopts('o:z:');
+
+# generates a deterministic dataset-like block of data (some repeated
+# patterns, some noise), compresses it and outputs it as a C header
+sub generate_zx0_fixture {
+    my $header = shift;
+    my $raw_file = "$header.raw";
+    my $zx0_file = "$header.raw.zx0";
+
+    my $seed = 1;
+    my $data = '';
+    while ( length( $data ) < $zx0_data_size ) {
+        $seed = ( $seed * 75 + 74 ) % 65537;
+        if ( $seed & 0x100 ) {
+            $data .= chr( $seed & 0xff );
+        } else {
+            $data .= pack( 'C*', ( 0x00, 0x18, 0x3c, 0x7e, 0xff, 0x7e, 0x3c, 0x18 ) );
+        }
+    }
+    $data = substr( $data, 0, $zx0_data_size );
+
+    open my $raw, ">:raw", $raw_file or
+        die "** Error: could not open $raw_file for writing\n";
+    print $raw $data;
+    close $raw;
+
+    system( $zx0, '-f', $raw_file, $zx0_file ) == 0 or
+        die "** Error: could not run $zx0\n";
+
+    open my $in, "<:raw", $zx0_file or
+        die "** Error: could not open $zx0_file for reading\n";
+    my $compressed = do { local $/; <$in> };
+    close $in;
+    unlink $raw_file, $zx0_file;
+
+    my @bytes = map { sprintf( '0x%02x', $_ ) } unpack( 'C*', $compressed );
+    open my $h, ">", $header or
+        die "** Error: could not open $header for writing\n";
+    print $h "// Generated by bench.pl - do not edit\n\n";
+    printf $h "#define BENCH_ZX0_DATA_SIZE\t%d\n\n", $zx0_data_size;
+    printf $h "uint8_t bench_zx0_data[ %d ] = {\n", scalar( @bytes );
+    while ( my @line = splice( @bytes, 0, 16 ) ) {
+        print $h "\t", join( ', ', @line ), ",\n";
+    }
+    print $h "};\n";
+    close $h;
+}
+
+# loads public symbols from a map file
+sub load_symbols {
+    my $map_file = shift;
+    my %address;
+    open my $map, "<", $map_file or
+        die "** Error: could not open $map_file for reading\n";
+    while ( my $line = <$map> ) {
+        chomp $line;
+        next if not $line =~ /; addr, public/;
+        if ( $line =~ /^([\w_]+)\s+=\s+\$([0-9a-fA-F]+)/ ) {
+            $address{ $1 } = hex( '0x' . $2 );
+        }
+    }
+    close $map;
+    return \%address;
+}
+
+# gets BENCH_ITERATIONS from the benchmark source file
+sub get_iterations {
+    my $src_file = shift;
+    open my $src, "<", $src_file or
+        die "** Error: could not open $src_file for reading\n";
+    while ( my $line = <$src> ) {
+        if ( $line =~ /^#define\s+BENCH_ITERATIONS\s+(\d+)/ ) {
+            close $src;
+            return $1;
+        }
+    }
+    close $src;
+    die "** Error: BENCH_ITERATIONS not found in $src_file\n";
+}
+
+# runs a benchmark binary and returns the number of T-states between the
+# start and end markers
+sub run_benchmark {
+    my $bin_file = shift;
+    ( my $base = $bin_file ) =~ s/\.bin$//;
+
+    my $symbols = load_symbols( "$base.map" );
+    defined( $symbols->{'_bench_start'} ) and defined( $symbols->{'_bench_end'} ) or
+        die "** Error: bench_start/bench_end markers not found in $base.map\n";
+    my $org = $symbols->{'__CRT_ORG_CODE'} || $default_org;
+
+    # z88dk-ticks loads the file at address 0, so we build a full 64K
+    # memory image with the binary at its ORG address
+    open my $bin, "<:raw", $bin_file or
+        die "** Error: could not open $bin_file for reading\n";
+    my $code = do { local $/; <$bin> };
+    close $bin;
+    my $image = "\x00" x 65536;
+    substr( $image, $org, length( $code ), $code );
+    my $image_file = "$base.img";
+    open my $img, ">:raw", $image_file or
+        die "** Error: could not open $image_file for writing\n";
+    print $img $image;
+    close $img;
+
+    my @cmd = ( $ticks,
+        '-pc', sprintf( '0x%04x', $org ),
+        '-start', sprintf( '0x%04x', $symbols->{'_bench_start'} ),
+        '-end', sprintf( '0x%04x', $symbols->{'_bench_end'} ),
+        $image_file );
+    my $output = `@cmd`;
+    ( $? == 0 ) or
+        die "** Error: could not run '@cmd'\n";
+    my @numbers = ( $output =~ /(\d+)/g );
+    scalar( @numbers ) or
+        die "** Error: no T-state count in output of '@cmd'\n";
+    return $numbers[ $#numbers ];
+}
+
+if ( defined( $opt_z ) ) {
+    generate_zx0_fixture( $opt_z );
+    exit 0;
+}
+
+scalar( @ARGV ) or
+    die "usage: $0 [-o <results_file>] <bench_xxx.bin>...\n       $0 -z <header_file>\n";
+
+my @lines;
+push @lines, sprintf( "%-36s %10s %12s %14s\n", 'Benchmark', 'Calls', 'T-states', 'T-states/call' );
+push @lines, sprintf( "%s\n", '-' x 75 );
+foreach my $bin_file ( sort @ARGV ) {
+    my $name = basename( $bin_file, '.bin' );
+    $name =~ s/^bench_//;
+    ( my $src_file = $bin_file ) =~ s/\.bin$/.c/;
+    my $iterations = get_iterations( $src_file );
+    my $tstates = run_benchmark( $bin_file );
+    push @lines, sprintf( "%-36s %10d %12d %14d\n", $name, $iterations, $tstates, int( $tstates / $iterations + 0.5 ) );
+}
+
+print @lines;
+if ( defined( $opt_o ) ) {
+    open my $out, ">", $opt_o or
+        die "** Error: could not open $opt_o for writing\n";
+    print $out @lines;
+    close $out;
+}
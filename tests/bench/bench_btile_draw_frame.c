@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: btile_draw_frame() of the animated btile in the bench screen,
+// alternating its frames
+
+#include "features.h"
+
+#include "rage1/btile.h"
+#include "rage1/dataset.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	100
+
+void main( void ) {
+    static uint8_t i;
+    static struct btile_pos_s *pos;
+    static struct btile_s *b;
+
+    bench_init();
+    pos = &game_state.current_screen_ptr->btile_data.btiles_pos[
+        game_state.current_screen_ptr->animated_btile_data.btiles[ 0 ].btile_pos_id ];
+    b = dataset_get_banked_btile_ptr( pos->btile_id );
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        btile_draw_frame( pos->row, pos->col, b, pos->type, &game_area, i & 1 );
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: bullet_animate_and_move_all() with all bullets active and
+// moving right in free rows of the bench screen.  The number of iterations
+// is limited so that bullets do not reach the game area border
+
+#include "features.h"
+
+#include "rage1/bullet.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	64
+
+void main( void ) {
+    static uint8_t i;
+    static struct bullet_state_data_s *bs;
+
+    bench_init();
+
+    game_state.bullet.movement.delay = 0;
+    for ( i = 0; i < BULLET_MAX_BULLETS; i++ ) {
+        bs = &game_state.bullet.bullets[ i ];
+        bs->position.x.part.integer = 16;
+        bs->position.y.part.integer = 16 + i * 8;
+        bs->dx = 1;
+        bs->dy = 0;
+        bs->delay_counter = 0;
+        SET_BULLET_FLAG( *bs, F_BULLET_ACTIVE );
+    }
+    game_state.bullet.active_bullets = BULLET_MAX_BULLETS;
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        bullet_animate_and_move_all();
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: collision_check() of the hero against the first enemy, in a
+// non-colliding position (all comparisons are done)
+
+#include "features.h"
+
+#include "rage1/collision.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	200
+
+void main( void ) {
+    static uint8_t i;
+    static struct position_data_s *enemy_pos;
+
+    bench_init();
+    enemy_pos = &game_state.current_screen_ptr->enemy_data.enemies[ 0 ].position;
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        collision_check( &game_state.hero.position, enemy_pos );
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: dzx0_standard() decompression of a dataset-sized block, as
+// done on dataset activation.  The compressed data is generated at build
+// time into bench_zx0_data.h (see README.md)
+
+#include <compress/zx0.h>
+
+#include "features.h"
+
+#include "bench.h"
+#include "bench_zx0_data.h"
+
+#define BENCH_ITERATIONS	1
+
+uint8_t bench_zx0_buffer[ BENCH_ZX0_DATA_SIZE ];
+
+void main( void ) {
+    static uint8_t i;
+
+    bench_init();
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        dzx0_standard( bench_zx0_data, bench_zx0_buffer );
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: enemy_animate_and_move() for all the enemies in the bench
+// screen
+
+#include "features.h"
+
+#include "rage1/enemy.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	100
+
+void main( void ) {
+    static uint8_t i;
+
+    bench_init();
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        enemy_animate_and_move(
+            game_state.current_screen_ptr->enemy_data.num_enemies,
+            game_state.current_screen_ptr->enemy_data.enemies
+        );
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: hero_can_move_in_direction() for all directions, from the
+// hero startup position in the bench screen
+
+#include "features.h"
+
+#include "rage1/hero.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	200
+
+const uint8_t directions[4] = { MOVE_UP, MOVE_DOWN, MOVE_LEFT, MOVE_RIGHT };
+
+void main( void ) {
+    static uint8_t i;
+
+    bench_init();
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        hero_can_move_in_direction( directions[ i & 3 ] );
+    bench_end();
+
+    bench_halt();
+}
@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: map_draw_screen() for the bench screen
+
+#include "features.h"
+
+#include "rage1/map.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	4
+
+void main( void ) {
+    static uint8_t i;
+
+    bench_init();
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        map_draw_screen( game_state.current_screen_ptr );
+    bench_end();
+
+    bench_halt();
+}
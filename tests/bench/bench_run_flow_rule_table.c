@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// RAGE1 - Retro Adventure Game Engine, release 1
+// (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+//
+// This code is published under a GNU GPL license version 3 or later.  See
+// LICENSE file in the distribution for details.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Benchmark: run_flow_rule_table() for the GAME_LOOP rule table of the
+// bench screen
+
+#include "features.h"
+
+#include "rage1/flow.h"
+#include "rage1/game_state.h"
+
+#include "game_data.h"
+
+#include "bench.h"
+
+#define BENCH_ITERATIONS	100
+
+void main( void ) {
+    static uint8_t i;
+
+    bench_init();
+
+    bench_start();
+    for ( i = 0; i < BENCH_ITERATIONS; i++ )
+        run_flow_rule_table( &game_state.current_screen_ptr->flow_data.rule_tables.game_loop );
+    bench_end();
+
+    bench_halt();
+}
@@ -27,7 +27,6 @@ my @codeset_valid_banks = ( 6, 1, 3, 7 );
 # banks allowed for datasets. All allowed, but contended are listed first
 my @dataset_valid_banks = ( 1, 3, 7, 6, 4 );
 
-my $num_available_banks = scalar( @dataset_valid_banks );
 
 my $max_bank_size = 16384;
 
@@ -39,6 +38,7 @@ my $bank_binaries_name_format = 'bank_%d.bin';
 my $bank_config_name = 'bank_bins.cfg';
 my $dataset_info_name = 'dataset_info.asm';
 my $codeset_info_name = 'codeset_info.asm';
+my $dataset_cache_info_name = 'dataset_cache_info.asm';
 my $basic_loader_name = 'loader.bas';
 
 ##
@@ -46,10 +46,18 @@ my $basic_loader_name = 'loader.bas';
 ##
 
 # parse command options
-our( $opt_i, $opt_o, $opt_b, $opt_s, $opt_l, $opt_c );
-getopts("i:o:s:l:c:");
+our( $opt_i, $opt_o, $opt_b, $opt_s, $opt_l, $opt_c, $opt_x, $opt_k );
+getopts("i:o:s:l:c:x:k:");
 ( defined( $opt_i ) and defined( $opt_o ) and defined( $opt_c ) ) or
-    die "usage: $0 -i <dataset_bin_dir> -c <codeset_bin_dir> -o <output_dir> -s <bank_switcher_binary> [-l <lowmem_output_dir>]\n";
+    die "usage: $0 -i <dataset_bin_dir> -c <codeset_bin_dir> -o <output_dir> -s <bank_switcher_binary> [-l <lowmem_output_dir>] [-x <excluded_bank>] [-k <num_dataset_cache_banks>]\n";
+
+# a bank may be reserved for other uses (e.g. input recording) and
+# excluded from the layout
+if ( defined( $opt_x ) ) {
+    @codeset_valid_banks = grep { $_ != $opt_x } @codeset_valid_banks;
+    @dataset_valid_banks = grep { $_ != $opt_x } @dataset_valid_banks;
+}
+my $num_available_banks = scalar( @dataset_valid_banks );
 
 # if $lowmem_output_dir is not specified, use same as $output_dir
 my ( $input_dir_ds, $input_dir_cs, $output_dir, $lowmem_output_dir ) = ( $opt_i, $opt_c, $opt_o, $opt_l || $opt_o );
@@ -65,6 +73,9 @@ foreach my $bin ( grep { /^dataset_.*\.zx0$/ } readdir BINDIR ) {
     $all_datasets[ $1 ] = {
             'name'	=> $bin,
             'size'	=> ( stat( "$input_dir_ds/$bin" ) )[7],
+            # the uncompressed binary is an intermediate make target, but
+            # a copy is always saved
+            'uncompressed_size'	=> ( stat( "$input_dir_ds/dataset_$1.bin.save" ) )[7],
             'dir'	=> $input_dir_ds,
             'type'	=> 'dataset',
     };
@@ -120,6 +131,13 @@ my $bank_layout = {
             },
 };
 
+# remove the excluded bank, if any, from the layout
+if ( defined( $opt_x ) ) {
+    ( $opt_x == 4 ) and
+        die "** Error: bank 4 is reserved for RAGE1 banked code, it can't be excluded\n";
+    delete $bank_layout->{ $opt_x };
+}
+
 # layout codeset binaries
 # a codeset is directly assigned to the start of a bank
 my $laid_out_codesets = 0;
@@ -240,6 +258,19 @@ foreach my $bank ( keys %$bank_layout ) {
     }
 }
 
+## if a dataset cache has been requested, reserve the needed banks from
+## the ones that have been left empty
+
+my @dataset_cache_banks;
+if ( defined( $opt_k ) and $opt_k ) {
+    @dataset_cache_banks = grep { not $bank_layout->{ $_ }{'size'} } @dataset_valid_banks;
+    ( scalar( @dataset_cache_banks ) >= $opt_k ) or
+        die sprintf( "** Error: dataset cache needs %d free banks, but only %d are available\n",
+            $opt_k, scalar( @dataset_cache_banks ) );
+    splice( @dataset_cache_banks, $opt_k );
+    $bank_layout->{ $_ }{'dataset_cache'} = 1 for @dataset_cache_banks;
+}
+
 ## all is ready, report
 
 print "Bank layout:\n";
@@ -256,6 +287,9 @@ foreach my $bank ( @sorted_banks ) {
         printf "CS-%d(%db) - ", $csnum,$bank_layout->{ $bank }{'binaries'}[0]{'size'};
         $total += $bank_layout->{ $bank }{'binaries'}[0]{'size'};
     }
+    if ( $bank_layout->{ $bank }{'dataset_cache'} ) {
+        print "DATASET_CACHE - ";
+    }
     if ( defined( $bank_layout->{ $bank }{'datasets'} ) ) {
         print join( '', map { 
                 $total += $all_datasets[ $_ ]{'size'};
@@ -361,3 +395,40 @@ foreach my $ds ( 0 .. scalar( @all_datasets ) - 1 ) {
 
 close $dsmap_h;
 print "OK\n";
+
+# generate ASM stub with the dataset cache configuration
+if ( scalar( @dataset_cache_banks ) ) {
+    print "Generating $dataset_cache_info_name...";
+
+    my $dscache = $output_dir . '/' . $dataset_cache_info_name;
+    open my $dscache_h, ">", $dscache
+        or die "\n** Error: could not open $dscache for writing\n";
+    print $dscache_h <<EOF_DSCACHE
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;; Dataset Cache: memory banks used for the dataset cache, and uncompressed
+;; size of each dataset
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;
+;; uint8_t dataset_cache_banks[ DATASET_CACHE_SIZE ] = { ... }
+;; uint16_t dataset_uncompressed_size[ $num_datasets ] = { ... }
+;;
+
+section         code_crt_common
+
+public		_dataset_cache_banks
+public		_dataset_uncompressed_size
+
+_dataset_cache_banks:
+EOF_DSCACHE
+;
+    printf $dscache_h "\t\tdb\t%d\n", $_ for @dataset_cache_banks;
+    print $dscache_h "\n_dataset_uncompressed_size:\n";
+    foreach my $ds ( 0 .. scalar( @all_datasets ) - 1 ) {
+        defined( $all_datasets[ $ds ]{'uncompressed_size'} ) or
+            die "\n** Error: could not find uncompressed binary for dataset $ds\n";
+        printf $dscache_h "\t\tdw\t%d\t;; dataset %d\n", $all_datasets[ $ds ]{'uncompressed_size'}, $ds;
+    }
+
+    close $dscache_h;
+    print "OK\n";
+}
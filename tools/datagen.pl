@@ -111,6 +111,19 @@ my $dump_file = 'internal_state.dmp';
 # valid values for Tracker type
 my @valid_trackers = qw( arkos2 vortex2 );
 
+# game loop tasks that can be configured with TASK directives, and their
+# default scheduling
+my @game_loop_tasks = qw( ENEMIES BULLETS HERO COLLISIONS BTILES TIMERS HEARTBEAT );
+my %game_loop_task_defaults = (
+    ENEMIES	=> { period => 1, phase => 0, priority => 'HIGH' },
+    BULLETS	=> { period => 1, phase => 0, priority => 'HIGH' },
+    HERO	=> { period => 1, phase => 0, priority => 'HIGH' },
+    COLLISIONS	=> { period => 1, phase => 0, priority => 'HIGH' },
+    BTILES	=> { period => 1, phase => 0, priority => 'LOW' },
+    TIMERS	=> { period => 1, phase => 0, priority => 'LOW' },
+    HEARTBEAT	=> { period => 8, phase => 0, priority => 'LOW' },
+);
+
 # output lines for each of the files
 my @c_game_data_lines;
 my $c_dataset_lines;	# hashref: dataset_id => [ C dataset lines ]
@@ -143,6 +156,7 @@ my @valid_game_functions = qw( menu intro game_end game_over user_init user_game
 # SPRITE_ENGINE_* is NOT here - it is added in generate_game_config based on game data
 my @default_build_features = qw(
     BTILE_2BIT_TYPE_MAP
+    ENEMY_ACTIVE_LIST
     GAME_TIME
 );
 
@@ -383,6 +397,11 @@ sub read_input_data {
                     $cur_sprite->{'frames'} = $1;
                     next;
                 }
+                if ( $line =~ /^PRESHIFT\s+(\d+)$/ ) {
+                    $cur_sprite->{'preshift'} = $1;
+                    add_build_feature( 'SPRITE_PRESHIFTED' );
+                    next;
+                }
                 if ( $line =~ /^REAL_PIXEL_WIDTH\s+(\d+)$/ ) {
                     $cur_sprite->{'real_pixel_width'} = $1;
                     next;
@@ -860,6 +879,35 @@ sub read_input_data {
                     }
                     next;
                 }
+                if ( $line =~ /^SOUND_PRIORITY\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $vars = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    foreach my $k ( keys %$vars ) {
+                        $game_config->{'sound_priorities'}{ $k } = $vars->{ $k };
+                    }
+                    next;
+                }
+                if ( $line =~ /^BEEPER\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'BLOCKING' );
+                    if ( ( $item->{'mode'} ne 'BLOCKING' ) and ( $item->{'mode'} ne 'INTERRUPT' ) ) {
+                        die "BEEPER: $file, line $current_line: MODE must be one of BLOCKING, INTERRUPT\n";
+                    }
+                    $game_config->{'beeper'} = $item;
+                    if ( $item->{'mode'} eq 'INTERRUPT' ) {
+                        add_build_feature( 'BEEPER_ISR_FX' );
+                    }
+                    next;
+                }
                 if ( $line =~ /^(GAME_AREA|LIVES_AREA|INVENTORY_AREA|DEBUG_AREA|TITLE_AREA)\s+(\w.*)$/ ) {
                     # ARG1=val1 ARG2=va2 ARG3=val3...
                     my ( $directive, $args ) = ( $1, $2 );
@@ -1086,6 +1134,211 @@ sub read_input_data {
                     add_build_feature( 'CUSTOM_STATE_DATA' );
                     next;
                 }
+                if ( $line =~ /^FLOW_RULES\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $game_config->{'flow_rules'} = $item;
+                    if ( $item->{'dirty_masks'} ) {
+                        add_build_feature( 'FLOW_DIRTY_MASKS' );
+                    }
+                    if ( $item->{'compiled'} ) {
+                        add_build_feature( 'FLOW_COMPILED_RULES' );
+                    }
+                    if ( $item->{'hotzone_occupancy'} ) {
+                        add_build_feature( 'HOTZONE_OCCUPANCY' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^SCREEN_DRAW\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'ATOMIC' );
+                    if ( ( $item->{'mode'} ne 'ATOMIC' ) and ( $item->{'mode'} ne 'INCREMENTAL' ) ) {
+                        die "SCREEN_DRAW: $file, line $current_line: MODE must be one of ATOMIC, INCREMENTAL\n";
+                    }
+                    $game_config->{'screen_draw'} = $item;
+                    if ( $item->{'mode'} eq 'INCREMENTAL' ) {
+                        add_build_feature( 'MAP_INCREMENTAL_DRAW' );
+                    }
+                    if ( $item->{'prerender'} ) {
+                        add_build_feature( 'MAP_PRERENDERED_SCREENS' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^ANIMATION\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $game_config->{'animation'} = $item;
+                    if ( $item->{'clocks'} ) {
+                        add_build_feature( 'ANIMATION_CLOCKS' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^SPRITE_ALLOCATION\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'DYNAMIC' );
+                    if ( ( $item->{'mode'} ne 'DYNAMIC' ) and ( $item->{'mode'} ne 'POOL' ) ) {
+                        die "SPRITE_ALLOCATION: $file, line $current_line: MODE must be one of DYNAMIC, POOL\n";
+                    }
+                    $game_config->{'sprite_allocation'} = $item;
+                    if ( $item->{'mode'} eq 'POOL' ) {
+                        add_build_feature( 'SPRITE_POOL' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^SCHEDULER\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $game_config->{'scheduler'} = $item;
+                    next;
+                }
+                if ( $line =~ /^TASK\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    if ( not defined( $item->{'name'} ) ) {
+                        die "TASK: $file, line $current_line: missing NAME argument\n";
+                    }
+                    $item->{'name'} = uc( $item->{'name'} );
+                    if ( not defined( $game_loop_task_defaults{ $item->{'name'} } ) ) {
+                        die sprintf( "TASK: $file, line $current_line: NAME must be one of %s\n",
+                            join( ', ', @game_loop_tasks ) );
+                    }
+                    if ( defined( $item->{'priority'} ) ) {
+                        $item->{'priority'} = uc( $item->{'priority'} );
+                        if ( ( $item->{'priority'} ne 'HIGH' ) and ( $item->{'priority'} ne 'LOW' ) ) {
+                            die "TASK: $file, line $current_line: PRIORITY must be one of HIGH, LOW\n";
+                        }
+                    }
+                    if ( $item->{'half_sets'} ) {
+                        if ( $item->{'name'} ne 'ENEMIES' ) {
+                            die "TASK: $file, line $current_line: HALF_SETS can only be used with NAME=ENEMIES\n";
+                        }
+                        add_build_feature( 'ENEMY_MOVE_HALF_SETS' );
+                    }
+                    if ( $item->{'name'} eq 'HEARTBEAT' ) {
+                        add_build_feature( 'GAME_LOOP_HEARTBEAT' );
+                    }
+                    $game_config->{'tasks'}{ $item->{'name'} } = $item;
+                    next;
+                }
+                if ( $line =~ /^COLLISIONS\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'BRUTE_FORCE' );
+                    if ( ( $item->{'mode'} ne 'BRUTE_FORCE' ) and ( $item->{'mode'} ne 'GRID' ) ) {
+                        die "COLLISIONS: $file, line $current_line: MODE must be one of BRUTE_FORCE, GRID\n";
+                    }
+                    $game_config->{'collisions'} = $item;
+                    if ( $item->{'mode'} eq 'GRID' ) {
+                        add_build_feature( 'COLLISION_GRID' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^TILE_TYPE_MAP\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'RUNTIME' );
+                    if ( ( $item->{'mode'} ne 'RUNTIME' ) and ( $item->{'mode'} ne 'PRECOMPILED' ) ) {
+                        die "TILE_TYPE_MAP: $file, line $current_line: MODE must be one of RUNTIME, PRECOMPILED\n";
+                    }
+                    $game_config->{'tile_type_map'} = $item;
+                    if ( $item->{'mode'} eq 'PRECOMPILED' ) {
+                        add_build_feature( 'BTILE_PRECOMPILED_TYPE_MAP' );
+                    }
+                    if ( $item->{'obstacle_bitmap'} ) {
+                        add_build_feature( 'BTILE_OBSTACLE_BITMAP' );
+                    }
+                    if ( $item->{'object_slots'} ) {
+                        add_build_feature( 'BTILE_OBJECT_SLOTS' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^BTILE_CELLS\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    $item->{'mode'} = uc( $item->{'mode'} || 'POINTERS' );
+                    if ( ( $item->{'mode'} ne 'POINTERS' ) and ( $item->{'mode'} ne 'OFFSETS' ) ) {
+                        die "BTILE_CELLS: $file, line $current_line: MODE must be one of POINTERS, OFFSETS\n";
+                    }
+                    $game_config->{'btile_cells'} = $item;
+                    if ( $item->{'mode'} eq 'OFFSETS' ) {
+                        add_build_feature( 'BTILE_CELL_OFFSETS' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^DATASET_CACHE\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    if ( not defined( $item->{'size'} ) ) {
+                        die "DATASET_CACHE: $file, line $current_line: missing SIZE argument\n";
+                    }
+                    $game_config->{'dataset_cache'} = $item;
+                    add_build_feature( 'DATASET_CACHE' );
+                    if ( $item->{'prefetch'} ) {
+                        add_build_feature( 'DATASET_PREFETCH' );
+                    }
+                    next;
+                }
+                if ( $line =~ /^INPUT_REPLAY\s+(\w.*)$/ ) {
+                    # ARG1=val1 ARG2=va2 ARG3=val3...
+                    my $args = $1;
+                    my $item = {
+                        map { my ($k,$v) = split( /=/, $_ ); lc($k), $v }
+                        split( /\s+/, $args )
+                    };
+                    if ( not defined( $item->{'mode'} ) ) {
+                        die "INPUT_REPLAY: $file, line $current_line: missing MODE argument\n";
+                    }
+                    $item->{'mode'} = uc( $item->{'mode'} );
+                    if ( ( $item->{'mode'} ne 'RECORD' ) and ( $item->{'mode'} ne 'PLAY' ) ) {
+                        die "INPUT_REPLAY: $file, line $current_line: MODE must be one of RECORD, PLAY\n";
+                    }
+                    $game_config->{'input_replay'} = $item;
+                    add_build_feature( 'INPUT_REPLAY' );
+                    add_build_feature( 'INPUT_REPLAY_' . $item->{'mode'} );
+                    next;
+                }
                 if ( $line =~ /^SINGLE_USE_BLOB\s+(.*)$/ ) {
                     # ARG1=val1 ARG2=va2 ARG3=val3...
                     my $args = $1;
@@ -1299,6 +1552,15 @@ sub validate_and_compile_sprite {
         }
     }
 
+    # pre-shifted sprites: PRESHIFT is the number of horizontal shifts
+    if ( defined( $sprite->{'preshift'} ) ) {
+        grep { $sprite->{'preshift'} == $_ } ( 2, 4, 8 ) or
+            die "Sprite '$sprite->{name}': PRESHIFT must be one of 2, 4, 8\n";
+        $sprite->{'preshift_bits'} = { 2 => 1, 4 => 2, 8 => 3 }->{ $sprite->{'preshift'} };
+    } else {
+        $sprite->{'preshift_bits'} = 0;
+    }
+
     # Always define the sequence 'Main', with all frames in order, first to last
     my $index = ( defined( $sprite->{'sequences'} ) ? scalar( @{ $sprite->{'sequences'} } ) : 0 );
     push @{ $sprite->{'sequences'} },
@@ -1344,13 +1606,53 @@ sub generate_sprite {
     # up to 14 bytes before sp->pixels (the leading blank row provides this preamble).
     my @col_bytes;
     my @mask_bytes;
-    foreach my $frm ( 0 .. ( $sprite_frames - 1 ) ) {
-        foreach my $col ( 0 .. ( $sprite_cols - 1 ) ) {
-            push @col_bytes, (0) x 8;	# initial row with blank pixels and transparent mask
-            push @mask_bytes, (0xff) x 8;
+    if ( $sprite->{'preshift_bits'} ) {
+        # Pre-shifted sprites: each frame is stored PRESHIFT times, each one
+        # shifted right by 8/PRESHIFT pixels more than the previous one, so
+        # the sprite is drawn without rotation.  Shifted frames have an
+        # extra column to the right for the bits that get shifted out
+        my $pixel_step = 8 >> $sprite->{'preshift_bits'};
+        foreach my $frm ( 0 .. ( $sprite_frames - 1 ) ) {
+            # a line of pixels/mask across all columns, plus the extra column
+            my @pixel_lines;
+            my @mask_lines;
             foreach my $row ( 0 .. ( $sprite_rows - 1 ) ) {
-                push @col_bytes, @{ $sprite->{'pixel_bytes'}[ ( $frm * $sprite_rows * $sprite_cols ) + $row * $sprite_cols + $col ] };
-                push @mask_bytes,@{ $sprite->{'mask_bytes'}[ ( $frm * $sprite_rows * $sprite_cols ) + $row * $sprite_cols + $col ] };
+                foreach my $line ( 0 .. 7 ) {
+                    my ( $pixels, $mask ) = ( 0, 0 );
+                    foreach my $col ( 0 .. ( $sprite_cols - 1 ) ) {
+                        my $cell = ( $frm * $sprite_rows * $sprite_cols ) + $row * $sprite_cols + $col;
+                        $pixels = ( $pixels << 8 ) | $sprite->{'pixel_bytes'}[ $cell ][ $line ];
+                        $mask = ( $mask << 8 ) | $sprite->{'mask_bytes'}[ $cell ][ $line ];
+                    }
+                    push @pixel_lines, $pixels << 8;
+                    push @mask_lines, ( $mask << 8 ) | 0xff;
+                }
+            }
+            my $line_bits = ( $sprite_cols + 1 ) * 8;
+            foreach my $shift ( 0 .. ( $sprite->{'preshift'} - 1 ) ) {
+                my $bits = $shift * $pixel_step;
+                # the mask is filled with transparent bits from the left
+                my $mask_fill = ( ( 1 << $bits ) - 1 ) << ( $line_bits - $bits );
+                my @shifted_pixels = map { $_ >> $bits } @pixel_lines;
+                my @shifted_mask = map { ( $_ >> $bits ) | $mask_fill } @mask_lines;
+                foreach my $col ( 0 .. $sprite_cols ) {
+                    my $byte_shift = ( $sprite_cols - $col ) * 8;
+                    push @col_bytes, (0) x 8;	# initial row with blank pixels and transparent mask
+                    push @mask_bytes, (0xff) x 8;
+                    push @col_bytes, map { ( $_ >> $byte_shift ) & 0xff } @shifted_pixels;
+                    push @mask_bytes, map { ( $_ >> $byte_shift ) & 0xff } @shifted_mask;
+                }
+            }
+        }
+    } else {
+        foreach my $frm ( 0 .. ( $sprite_frames - 1 ) ) {
+            foreach my $col ( 0 .. ( $sprite_cols - 1 ) ) {
+                push @col_bytes, (0) x 8;	# initial row with blank pixels and transparent mask
+                push @mask_bytes, (0xff) x 8;
+                foreach my $row ( 0 .. ( $sprite_rows - 1 ) ) {
+                    push @col_bytes, @{ $sprite->{'pixel_bytes'}[ ( $frm * $sprite_rows * $sprite_cols ) + $row * $sprite_cols + $col ] };
+                    push @mask_bytes,@{ $sprite->{'mask_bytes'}[ ( $frm * $sprite_rows * $sprite_cols ) + $row * $sprite_cols + $col ] };
+                }
             }
         }
     }
@@ -1378,8 +1680,15 @@ sub generate_sprite {
     # Both SP1 and JSP: each frame is (rows+1)*cols*16 bytes; first frame starts at offset 16
     # (past the leading blank row of column 0), so sp->pixels - (ypos%8)*2 always lands within
     # the blank preamble area for any sub-character vertical offset.
+    # For pre-shifted sprites, the frame pointer points to the unshifted
+    # version of the frame, and the shifted versions follow it every
+    # 'preshift_stride' bytes
     my @frame_offsets;
     my $frame_stride = 16 * ( $sprite->{'rows'} + 1 ) * $sprite->{'cols'};
+    if ( $sprite->{'preshift_bits'} ) {
+        $sprite->{'preshift_stride'} = 16 * ( $sprite->{'rows'} + 1 ) * ( $sprite->{'cols'} + 1 );
+        $frame_stride = $sprite->{'preshift_stride'} * $sprite->{'preshift'};
+    }
     my $ptr = 16;
     foreach ( 0 .. ( $sprite->{'frames'} - 1 ) ) {
         push @frame_offsets, $ptr;
@@ -1628,9 +1937,14 @@ sub generate_screen {
             $screen->{'name'},
             scalar( @{$screen->{'btiles'}} ) );
 
+        # with a precompiled tile type map, btiles without state are already
+        # in the map and do not need to update it when drawn
+        my $precompiled_type_map = is_build_feature_enabled( 'BTILE_PRECOMPILED_TYPE_MAP' );
         push @{ $c_dataset_lines->{ $dataset } }, join( ",\n", map {
-                sprintf("\t{ .type = TT_%s, .row = %d, .col = %d, .btile_id = %d, .state_index = %s }",
-                    uc($_->{'type'}), $_->{'row'}, $_->{'col'},
+                sprintf("\t{ .type = %s, .row = %d, .col = %d, .btile_id = %d, .state_index = %s }",
+                    ( ( $precompiled_type_map and ( "$_->{'asset_state_index'}" eq 'ASSET_NO_STATE' ) ) ?
+                        'TT_PRECOMPILED' : 'TT_' . uc( $_->{'type'} ) ),
+                    $_->{'row'}, $_->{'col'},
                     $btile_global_to_dataset_index->{ $btile_name_to_index{ $_->{'btile'} } },
                     ( "$_->{'asset_state_index'}" eq 'ASSET_NO_STATE' ? 'ASSET_NO_STATE' : $_->{'asset_state_index'} ) )
             } @{$screen->{'btiles'}} );
@@ -1659,6 +1973,11 @@ sub generate_screen {
                     push @{ $c_dataset_lines->{ $dataset } }, sprintf( ".anim.delay_data.sequence_delay = %d, ",
                         $btile->{'sequence_delay'}
                     );
+                    if ( is_build_feature_enabled( 'ANIMATION_CLOCKS' ) ) {
+                        push @{ $c_dataset_lines->{ $dataset } }, sprintf( ".anim.delay_data.clock = %d, ",
+                            $btile->{'animation_clock'}
+                        );
+                    }
                     push @{ $c_dataset_lines->{ $dataset } }, sprintf( ".anim.current.sequence = %d },\n",
                         $all_btiles[ $btile_name_to_index{ $btile->{'btile'} } ]{'sequence_name_to_index'}{ $btile->{'sequence'} }
                     );
@@ -1669,6 +1988,16 @@ sub generate_screen {
         }
     }
 
+    # screen tile type map
+    if ( is_build_feature_enabled( 'BTILE_PRECOMPILED_TYPE_MAP' ) ) {
+        generate_screen_tile_type_map( $screen, $dataset );
+    }
+
+    # screen pre-rendered static layer
+    if ( is_build_feature_enabled( 'MAP_PRERENDERED_SCREENS' ) ) {
+        generate_screen_static_layer( $screen, $dataset );
+    }
+
     # screen enemies
     if ( scalar( @{ $screen->{'enemies'} } ) ) {
         push @{ $c_dataset_lines->{ $dataset } }, sprintf( "// Screen '%s' enemy data\n", $screen->{'name'} );
@@ -1678,12 +2007,12 @@ sub generate_screen {
         push @{ $c_dataset_lines->{ $dataset } }, join( ",\n", map {
                 sprintf( "\t{ .sprite = %s, .num_graphic = %d, .color = %s,\n" .
                         "\t\t.animation = {\n" .
-                        "\t\t\t.delay_data = { .frame_delay = %d, .sequence_delay = %d },\n" .
+                        "\t\t\t.delay_data = { .frame_delay = %d, .sequence_delay = %d%s },\n" .
                         "\t\t\t.sequence_data = { .initial_sequence = %d },\n" .
                         "\t\t\t.current =  { .sequence = %d, .sequence_counter = %d, .frame_delay_counter = %d, .sequence_delay_counter = %d } },\n" .
                         "\t\t.position = { .x.value = %d , .y.value = %d, .xmax = %d, .ymax = %d },\n" .
                         "\t\t.movement = { .type = %s, .delay = %d, .delay_counter = %d,\n" .
-                        "\t\t\t.data = { .%s = { %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d } },\n" .
+                        "\t\t\t.data = { .%s = { %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d%s } },\n" .
                         "\t\t\t.flags = %s },\n" .
                         "\t\t.state_index = %s }",
                     # SP1 sprite pointer, will be initialized later
@@ -1695,6 +2024,7 @@ sub generate_screen {
 
                     # animation_data: delay_data values
                     $_->{'animation_delay'}, ( $_->{'sequence_delay'} || 0 ),
+                    ( is_build_feature_enabled( 'ANIMATION_CLOCKS' ) ? sprintf( ", .clock = %d", $_->{'animation_clock'} ) : '' ),
                     # animation_data: sequence_data values
                     $all_sprites[ $sprite_name_to_index{ $_->{'sprite'} } ]{'sequence_name_to_index'}{ $_->{'initial_sequence'} },
                     # animation_data: current values
@@ -1715,6 +2045,9 @@ sub generate_screen {
                     $_->{'dx'}, $_->{'dy'},
                     $all_sprites[ $sprite_name_to_index{ $_->{'sprite'} } ]{'sequence_name_to_index'}{ $_->{'sequence_a'} },
                     $all_sprites[ $sprite_name_to_index{ $_->{'sprite'} } ]{'sequence_name_to_index'}{ $_->{'sequence_b'} },
+                    # configured limits for enemies with runtime bounce limits
+                    ( is_build_feature_enabled( 'ENEMY_BOUNCE_LIMITS' ) ?
+                        sprintf( ", %d, %d", ( $_->{'limit_min'} || 0 ), ( $_->{'limit_max'} || 0 ) ) : '' ),
                     # movement flags
                     $_->{'movement_flags'},
 
@@ -1773,7 +2106,9 @@ sub generate_screen {
         push @{ $c_dataset_lines->{ $dataset } }, "\n};\n\n";
     }
 
-    # flow rules
+    # flow rules - with compiled rules, they are generated as code in the
+    # home bank
+    return if is_build_feature_enabled( 'FLOW_COMPILED_RULES' );
     push @{ $c_dataset_lines->{ $dataset } }, sprintf( "// Screen '%s' flow rules\n", $screen->{'name'} );
     foreach my $table ( @{ $syntax->{'valid_whens'} } ) {
         if ( defined( $screen->{'rules'} ) and defined( $screen->{'rules'}{ $table } ) ) {
@@ -1793,6 +2128,203 @@ sub generate_screen {
 
 }
 
+# generates the precompiled tile type map for a screen: the types of all
+# btiles without state, in the same layout as screen_pos_tile_type_data
+# (packed 4 tiles per byte if BTILE_2BIT_TYPE_MAP is enabled).  The map is
+# RLE encoded as (count,value) byte pairs, ended by a 0 count.  If
+# BTILE_OBSTACLE_BITMAP is enabled, the obstacle bitmap for the same btiles
+# follows, in the layout of screen_obstacle_bitmap and with the same
+# encoding, so that the engine does not need to rebuild it
+sub generate_screen_tile_type_map {
+    my ( $screen, $dataset ) = @_;
+
+    my %tile_type_value = ( DECORATION => 0, OBSTACLE => 1, ITEM => 2, HARMFUL => 3 );
+    my $area = $game_config->{'game_area'};
+
+    # build the unpacked map, btiles are applied in drawing order and
+    # clipped to the game area, just like btile_draw does
+    my @type_map = ( 0 ) x ( 24 * 32 );
+    foreach my $btile ( grep { "$_->{'asset_state_index'}" eq 'ASSET_NO_STATE' } @{ $screen->{'btiles'} } ) {
+        my $bt = $all_btiles[ $btile_name_to_index{ $btile->{'btile'} } ];
+        my $type = $tile_type_value{ uc( $btile->{'type'} ) };
+        defined( $type ) or
+            die "Screen '$screen->{name}': invalid type '$btile->{type}' for btile '$btile->{btile}'\n";
+        foreach my $r ( $btile->{'row'} .. ( $btile->{'row'} + $bt->{'rows'} - 1 ) ) {
+            next if ( ( $r < $area->{'top'} ) or ( $r > $area->{'bottom'} ) );
+            foreach my $c ( $btile->{'col'} .. ( $btile->{'col'} + $bt->{'cols'} - 1 ) ) {
+                next if ( ( $c < $area->{'left'} ) or ( $c > $area->{'right'} ) );
+                $type_map[ $r * 32 + $c ] = $type;
+            }
+        }
+    }
+
+    my @bytes;
+    if ( is_build_feature_enabled( 'BTILE_2BIT_TYPE_MAP' ) ) {
+        @bytes = map {
+            my $i = $_ * 4;
+            $type_map[ $i ] | ( $type_map[ $i + 1 ] << 2 ) | ( $type_map[ $i + 2 ] << 4 ) | ( $type_map[ $i + 3 ] << 6 )
+        } ( 0 .. ( scalar( @type_map ) / 4 - 1 ) );
+    } else {
+        @bytes = @type_map;
+    }
+
+    my @rle = rle_encode_pairs( @bytes );
+
+    # obstacle bitmap: 4 bytes per row, bit 7 is the leftmost column
+    if ( is_build_feature_enabled( 'BTILE_OBSTACLE_BITMAP' ) ) {
+        my @bitmap = ( 0 ) x ( 24 * 4 );
+        foreach my $pos ( grep { $type_map[ $_ ] == $tile_type_value{'OBSTACLE'} } ( 0 .. $#type_map ) ) {
+            my ( $r, $c ) = ( int( $pos / 32 ), $pos % 32 );
+            $bitmap[ $r * 4 + ( $c >> 3 ) ] |= ( 0x80 >> ( $c & 0x07 ) );
+        }
+        push @rle, rle_encode_pairs( @bitmap );
+    }
+
+    push @{ $c_dataset_lines->{ $dataset } }, sprintf( "// Screen '%s' tile type map\n", $screen->{'name'} );
+    push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t screen_%s_tile_type_map[ %d ] = {\n",
+        $screen->{'name'}, scalar( @rle ) );
+    while ( my @line = splice( @rle, 0, 16 ) ) {
+        push @{ $c_dataset_lines->{ $dataset } }, "\t" . join( ", ", map { sprintf( "0x%02x", $_ ) } @line ) . ",\n";
+    }
+    push @{ $c_dataset_lines->{ $dataset } }, "};\n\n";
+}
+
+# RLE encodes a list of bytes as (count,value) byte pairs, ended by a 0
+# count, for btile_load_type_map()
+sub rle_encode_pairs {
+    my @bytes = @_;
+    my @rle;
+    my $i = 0;
+    while ( $i < scalar( @bytes ) ) {
+        my $count = 1;
+        $count++ while ( ( $i + $count < scalar( @bytes ) ) and ( $count < 255 ) and ( $bytes[ $i + $count ] == $bytes[ $i ] ) );
+        push @rle, $count, $bytes[ $i ];
+        $i += $count;
+    }
+    push @rle, 0;
+    return @rle;
+}
+
+# RLE encodes a list of bytes for the engine decoders: a count byte with the
+# high bit set is followed by a byte which is repeated (count & 0x7F)
+# times, and a count byte without it is followed by that number of literal
+# bytes.  A 0 count ends the data
+sub rle_encode_runs {
+    my @bytes = @_;
+    my @rle;
+    my @literals;
+    my $i = 0;
+    while ( $i < scalar( @bytes ) ) {
+        my $run = 1;
+        $run++ while ( ( $i + $run < scalar( @bytes ) ) and ( $run < 127 ) and ( $bytes[ $i + $run ] == $bytes[ $i ] ) );
+        if ( $run >= 3 ) {
+            push @rle, scalar( @literals ), splice( @literals ) if scalar( @literals );
+            push @rle, 0x80 | $run, $bytes[ $i ];
+            $i += $run;
+        } else {
+            push @literals, $bytes[ $i++ ];
+            push @rle, scalar( @literals ), splice( @literals ) if ( scalar( @literals ) == 127 );
+        }
+    }
+    push @rle, scalar( @literals ), splice( @literals ) if scalar( @literals );
+    push @rle, 0;
+    return @rle;
+}
+
+# generates the pre-rendered static layer for a screen: all btiles
+# without state (and the background, if it is not random) are flattened
+# into a grid of cells for the game area.  Each cell is an index into a
+# palette of (tile,attr) pairs for the screen, 0 meaning an empty cell.
+# The grid is RLE encoded.  If the screen uses more than 255 different
+# pairs, it is not pre-rendered and it will be drawn as usual
+sub generate_screen_static_layer {
+    my ( $screen, $dataset ) = @_;
+
+    my $gamearea_color_full = is_build_feature_enabled( 'GAMEAREA_COLOR_FULL' );
+    my $area = $game_config->{'game_area'};
+    my $width = $area->{'right'} - $area->{'left'} + 1;
+    my $height = $area->{'bottom'} - $area->{'top'} + 1;
+    my $cell_offsets = $dataset_dependency{ $dataset }{'btile_cell_offsets'};
+
+    my @grid = ( 0 ) x ( $width * $height );
+    my @palette;
+    my %palette_index;
+
+    # draws a btile (frame 0) into the grid, clipped to a box
+    my $draw_btile = sub {
+        my ( $name, $row, $col, $box ) = @_;
+        my $bt = $all_btiles[ $btile_name_to_index{ $name } ];
+        my @attrs = ( $gamearea_color_full ? @{ $bt->{'attr'} || $bt->{'png_attr'} } : () );
+        my $n = 0;
+        foreach my $r ( $row .. ( $row + $bt->{'rows'} - 1 ) ) {
+            foreach my $c ( $col .. ( $col + $bt->{'cols'} - 1 ) ) {
+                my $cell = $n++;
+                next if ( ( $r < $box->{'top'} ) or ( $r > $box->{'bottom'} ) or
+                    ( $c < $box->{'left'} ) or ( $c > $box->{'right'} ) );
+                next if ( ( $r < $area->{'top'} ) or ( $r > $area->{'bottom'} ) or
+                    ( $c < $area->{'left'} ) or ( $c > $area->{'right'} ) );
+                my $offset = $cell_offsets->{ $name }[ $cell ];
+                my $attr = ( $gamearea_color_full ? $attrs[ $cell ] : '' );
+                my $key = "$offset:$attr";
+                if ( not defined( $palette_index{ $key } ) ) {
+                    push @palette, { offset => $offset, attr => $attr };
+                    $palette_index{ $key } = scalar( @palette );
+                }
+                $grid[ ( $r - $area->{'top'} ) * $width + ( $c - $area->{'left'} ) ] = $palette_index{ $key };
+            }
+        }
+    };
+
+    # the background is included only if it is always drawn complete
+    my $bg = $screen->{'background'};
+    my $prerender_background = ( defined( $bg ) and
+        ( ( defined( $bg->{'probability'} ) ? $bg->{'probability'} : 255 ) == 255 ) );
+    if ( $prerender_background ) {
+        my $bt = $all_btiles[ $btile_name_to_index{ $bg->{'btile'} } ];
+        my $box = {
+            top => $bg->{'row'}, bottom => $bg->{'row'} + $bg->{'height'} - 1,
+            left => $bg->{'col'}, right => $bg->{'col'} + $bg->{'width'} - 1,
+        };
+        for ( my $r = $box->{'top'}; $r <= $box->{'bottom'}; $r += $bt->{'rows'} ) {
+            for ( my $c = $box->{'left'}; $c <= $box->{'right'}; $c += $bt->{'cols'} ) {
+                $draw_btile->( $bg->{'btile'}, $r, $c, $box );
+            }
+        }
+    }
+
+    foreach my $btile ( grep { "$_->{'asset_state_index'}" eq 'ASSET_NO_STATE' } @{ $screen->{'btiles'} } ) {
+        $draw_btile->( $btile->{'btile'}, $btile->{'row'}, $btile->{'col'}, $area );
+    }
+
+    # too many different cells, the screen will be drawn as usual
+    if ( scalar( @palette ) > 255 ) {
+        $screen->{'static_layer_prerendered'} = 0;
+        return;
+    }
+    $screen->{'static_layer_prerendered'} = 1;
+    $screen->{'static_layer_prerendered_tiles'} = scalar( @palette );
+    $screen->{'background_prerendered'} = $prerender_background;
+
+    my @rle = rle_encode_runs( @grid );
+    push @{ $c_dataset_lines->{ $dataset } }, sprintf( "// Screen '%s' pre-rendered static layer\n", $screen->{'name'} );
+    if ( scalar( @palette ) ) {
+        push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t *screen_%s_static_tiles[ %d ] = {\n\t%s\n};\n",
+            $screen->{'name'}, scalar( @palette ),
+            join( ",\n\t", map { sprintf( "&all_dataset_btile_data[ %d ]", $_->{'offset'} ) } @palette ) );
+        if ( $gamearea_color_full ) {
+            push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t screen_%s_static_attrs[ %d ] = {\n\t%s\n};\n",
+                $screen->{'name'}, scalar( @palette ),
+                join( ",\n\t", map { $_->{'attr'} } @palette ) );
+        }
+    }
+    push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t screen_%s_static_grid[ %d ] = {\n",
+        $screen->{'name'}, scalar( @rle ) );
+    while ( my @line = splice( @rle, 0, 16 ) ) {
+        push @{ $c_dataset_lines->{ $dataset } }, "\t" . join( ", ", map { sprintf( "0x%02x", $_ ) } @line ) . ",\n";
+    }
+    push @{ $c_dataset_lines->{ $dataset } }, "};\n\n";
+}
+
 ###################################
 ## Hero functions
 ###################################
@@ -2231,6 +2763,57 @@ sub find_existing_rule_index {
     return undef;
 }
 
+# game state classes read by each rule check, used for skipping the
+# evaluation of rules whose inputs have not changed. See FLOW_DEP_*
+# definitions in flow.h
+my $check_dependency_mask = {
+    GAME_FLAG_IS_SET		=> 'FLOW_DEP_GAME_FLAGS',
+    GAME_FLAG_IS_RESET		=> 'FLOW_DEP_GAME_FLAGS',
+    LOOP_FLAG_IS_SET		=> 'FLOW_DEP_LOOP_FLAGS',
+    LOOP_FLAG_IS_RESET		=> 'FLOW_DEP_LOOP_FLAGS',
+    USER_FLAG_IS_SET		=> 'FLOW_DEP_USER_FLAGS',
+    USER_FLAG_IS_RESET		=> 'FLOW_DEP_USER_FLAGS',
+    LIVES_EQUAL			=> 'FLOW_DEP_LIVES',
+    LIVES_MORE_THAN		=> 'FLOW_DEP_LIVES',
+    LIVES_LESS_THAN		=> 'FLOW_DEP_LIVES',
+    ENEMIES_ALIVE_EQUAL		=> 'FLOW_DEP_ENEMIES',
+    ENEMIES_ALIVE_MORE_THAN	=> 'FLOW_DEP_ENEMIES',
+    ENEMIES_ALIVE_LESS_THAN	=> 'FLOW_DEP_ENEMIES',
+    ENEMIES_KILLED_EQUAL	=> 'FLOW_DEP_ENEMIES',
+    ENEMIES_KILLED_MORE_THAN	=> 'FLOW_DEP_ENEMIES',
+    ENEMIES_KILLED_LESS_THAN	=> 'FLOW_DEP_ENEMIES',
+    CALL_CUSTOM_FUNCTION	=> 'FLOW_DEP_ALWAYS',
+    ITEM_IS_OWNED		=> 'FLOW_DEP_INVENTORY',
+    HERO_OVER_HOTZONE		=> 'FLOW_DEP_HOTZONES',
+    SCREEN_FLAG_IS_SET		=> 'FLOW_DEP_SCREEN_FLAGS',
+    SCREEN_FLAG_IS_RESET	=> 'FLOW_DEP_SCREEN_FLAGS',
+    FLOW_VAR_EQUAL		=> 'FLOW_DEP_FLOW_VARS',
+    FLOW_VAR_MORE_THAN		=> 'FLOW_DEP_FLOW_VARS',
+    FLOW_VAR_LESS_THAN		=> 'FLOW_DEP_FLOW_VARS',
+    GAME_TIME_EQUAL		=> 'FLOW_DEP_GAME_TIME',
+    GAME_TIME_MORE_THAN		=> 'FLOW_DEP_GAME_TIME',
+    GAME_TIME_LESS_THAN		=> 'FLOW_DEP_GAME_TIME',
+    GAME_EVENT_HAPPENED		=> 'FLOW_DEP_GAME_EVENTS',
+    ITEM_IS_NOT_OWNED		=> 'FLOW_DEP_INVENTORY',
+    HERO_ENTERED_HOTZONE	=> 'FLOW_DEP_HOTZONES',
+    HERO_LEFT_HOTZONE		=> 'FLOW_DEP_HOTZONES',
+};
+
+# returns the dependency mask of a rule: the game state classes read by its
+# checks.  Rules with no checks must always run, so they are flagged as
+# always dirty.  Only used when dirty masks are enabled
+sub flow_rule_dependency_mask {
+    my $rule = shift;
+    my %deps;
+    foreach my $chk ( @{ $rule->{'check'} } ) {
+        my ( $check, $check_data ) = split( /\s+/, $chk );
+        defined( $check_dependency_mask->{ $check } ) or
+            die "Unknown CHECK '$check'\n";
+        $deps{ $check_dependency_mask->{ $check } }++;
+    }
+    return ( scalar( keys %deps ) ? join( ' | ', sort keys %deps ) : 'FLOW_DEP_ALWAYS' );
+}
+
 sub validate_and_compile_rule {
     my $rule = shift;
 
@@ -2267,10 +2850,15 @@ sub validate_and_compile_rule {
         my ( $check, $check_data ) = ( $1, $2 );
 
         # hotzone filtering
-        if ( $check =~ /^HERO_OVER_HOTZONE$/ ) {
+        if ( $check =~ /^HERO_(OVER|ENTERED|LEFT)_HOTZONE$/ ) {
             $check_data = $all_screens[ $screen_name_to_index{ $rule->{'screen'} } ]{'hotzone_name_to_index'}{ $check_data };
         }
 
+        # hotzone transitions are only tracked with hotzone occupancy
+        if ( $check =~ /^HERO_(ENTERED|LEFT)_HOTZONE$/ ) {
+            add_build_feature( 'HOTZONE_OCCUPANCY' );
+        }
+
         # check custom function filtering
         if ( $check =~ /^CALL_CUSTOM_FUNCTION/ ) {
             my $vars = {
@@ -2466,6 +3054,8 @@ my $check_data_output_format = {
     GAME_TIME_LESS_THAN		=> ".data.game_time.seconds = %s",
     GAME_EVENT_HAPPENED		=> ".data.game_event.event = %s",
     ITEM_IS_NOT_OWNED		=> ".data.item.item_id = %s",
+    HERO_ENTERED_HOTZONE	=> ".data.hotzone.num_hotzone = %s",
+    HERO_LEFT_HOTZONE		=> ".data.hotzone.num_hotzone = %s",
 };
 
 my $action_data_output_format = {
@@ -2520,10 +3110,10 @@ sub generate_rule_checks {
 }
 
 sub generate_rule_actions {
-    my ( $rule, $index ) = @_;
+    my ( $rule, $index, $prefix ) = @_;
     my $num_actions = scalar( @{ $rule->{'do'} } );
-    my $output = sprintf( "struct flow_rule_action_s flow_rule_actions_%05d[%d] = {\n",
-        $index, $num_actions );
+    my $output = sprintf( "struct flow_rule_action_s %s_%05d[%d] = {\n",
+        ( $prefix || 'flow_rule_actions' ), $index, $num_actions );
     foreach my $ac ( @{ $rule->{'do'} } ) {
         $ac =~ m/^(\w+)\s*(.*)$/;
         my ( $action, $action_data ) = ( $1, $2 );
@@ -2578,12 +3168,192 @@ FLOW_DATA_C_1
             );
             push @{ $c_dataset_lines->{ $dataset } }, sprintf( " .num_actions = %d, .actions = &flow_rule_actions_%05d[0],",
                 scalar( @{ $dataset_rules[ $i ]{'do'} } ), $i );
+            if ( is_build_feature_enabled( 'FLOW_DIRTY_MASKS' ) ) {
+                push @{ $c_dataset_lines->{ $dataset } }, sprintf( " .deps = %s,", flow_rule_dependency_mask( $dataset_rules[ $i ] ) );
+            }
             push @{ $c_dataset_lines->{ $dataset } }, " },\n";
         }
         push @{ $c_dataset_lines->{ $dataset } }, "\n};\n\n";
     }
 }
 
+# C expressions for compiled rule checks.  Data for the checks has already
+# been filtered in validate_and_compile_rule, and struct initializers (used
+# for checks with more than one argument) are available as a hash
+my $check_compiled_format = {
+    GAME_FLAG_IS_SET		=> sub { sprintf( "GET_GAME_FLAG( %s )", $_[0] ) },
+    GAME_FLAG_IS_RESET		=> sub { sprintf( "! GET_GAME_FLAG( %s )", $_[0] ) },
+    LOOP_FLAG_IS_SET		=> sub { sprintf( "GET_LOOP_FLAG( %s )", $_[0] ) },
+    LOOP_FLAG_IS_RESET		=> sub { sprintf( "! GET_LOOP_FLAG( %s )", $_[0] ) },
+    USER_FLAG_IS_SET		=> sub { sprintf( "GET_USER_FLAG( %s )", $_[0] ) },
+    USER_FLAG_IS_RESET		=> sub { sprintf( "! GET_USER_FLAG( %s )", $_[0] ) },
+    LIVES_EQUAL			=> sub { sprintf( "game_state.hero.health.num_lives == %d", $_[0] ) },
+    LIVES_MORE_THAN		=> sub { sprintf( "game_state.hero.health.num_lives > %d", $_[0] ) },
+    LIVES_LESS_THAN		=> sub { sprintf( "game_state.hero.health.num_lives < %d", $_[0] ) },
+    ENEMIES_ALIVE_EQUAL		=> sub { sprintf( "game_state.enemies_alive == %d", $_[0] ) },
+    ENEMIES_ALIVE_MORE_THAN	=> sub { sprintf( "game_state.enemies_alive > %d", $_[0] ) },
+    ENEMIES_ALIVE_LESS_THAN	=> sub { sprintf( "game_state.enemies_alive < %d", $_[0] ) },
+    ENEMIES_KILLED_EQUAL	=> sub { sprintf( "game_state.enemies_killed == %d", $_[0] ) },
+    ENEMIES_KILLED_MORE_THAN	=> sub { sprintf( "game_state.enemies_killed > %d", $_[0] ) },
+    ENEMIES_KILLED_LESS_THAN	=> sub { sprintf( "game_state.enemies_killed < %d", $_[0] ) },
+    CALL_CUSTOM_FUNCTION	=> sub { sprintf( "%s( %s )", $check_custom_functions[ $_[1]{'function_id'} ]{'function'}, $_[1]{'param'} ) },
+    ITEM_IS_OWNED		=> sub { sprintf( "INVENTORY_HAS_ITEM( &game_state.inventory, %s )", $_[0] ) },
+    HERO_OVER_HOTZONE		=> sub {
+        is_build_feature_enabled( 'HOTZONE_OCCUPANCY' ) ?
+            sprintf( "game_state.hotzones.over & HOTZONE_BIT( %s )", $_[0] ) :
+            sprintf( "flow_hero_over_hotzone( %s )", $_[0] )
+    },
+    SCREEN_FLAG_IS_SET		=> sub { sprintf( "GET_SCREEN_FLAG( game_state.current_screen_asset_state_table_ptr[ SCREEN_STATE_INDEX ].asset_state, %s )", $_[0] ) },
+    SCREEN_FLAG_IS_RESET	=> sub { sprintf( "! GET_SCREEN_FLAG( game_state.current_screen_asset_state_table_ptr[ SCREEN_STATE_INDEX ].asset_state, %s )", $_[0] ) },
+    FLOW_VAR_EQUAL		=> sub { sprintf( "all_flow_vars[ %s ] == %s", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    FLOW_VAR_MORE_THAN		=> sub { sprintf( "all_flow_vars[ %s ] > %s", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    FLOW_VAR_LESS_THAN		=> sub { sprintf( "all_flow_vars[ %s ] < %s", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    GAME_TIME_EQUAL		=> sub { sprintf( "game_state.game_time == %s", $_[0] ) },
+    GAME_TIME_MORE_THAN		=> sub { sprintf( "game_state.game_time > %s", $_[0] ) },
+    GAME_TIME_LESS_THAN		=> sub { sprintf( "game_state.game_time < %s", $_[0] ) },
+    GAME_EVENT_HAPPENED		=> sub { sprintf( "GET_GAME_EVENT( %s )", $_[0] ) },
+    ITEM_IS_NOT_OWNED		=> sub { sprintf( "! INVENTORY_HAS_ITEM( &game_state.inventory, %s )", $_[0] ) },
+    HERO_ENTERED_HOTZONE	=> sub { sprintf( "game_state.hotzones.entered & HOTZONE_BIT( %s )", $_[0] ) },
+    HERO_LEFT_HOTZONE		=> sub { sprintf( "game_state.hotzones.left & HOTZONE_BIT( %s )", $_[0] ) },
+};
+
+# C statements for the compiled rule actions that are simple enough to be
+# inlined.  The remaining ones are compiled as direct calls to their
+# do_rule_action_* functions in flow.c
+our $action_compiled_format = {
+    SET_USER_FLAG		=> sub { sprintf( "SET_USER_FLAG( %s );", $_[0] ) },
+    RESET_USER_FLAG		=> sub { sprintf( "RESET_USER_FLAG( %s );", $_[0] ) },
+    END_OF_GAME			=> sub { "SET_GAME_FLAG( F_GAME_END );" },
+    CALL_CUSTOM_FUNCTION	=> sub {
+        my $f = $action_custom_functions[ $_[1]{'function_id'} ];
+        sprintf( "%s( %s );", $f->{'function'}, ( $f->{'uses_param'} ? $_[1]{'param'} : '' ) );
+    },
+    SET_SCREEN_FLAG		=> sub { sprintf( "SET_SCREEN_FLAG( all_screen_asset_state_tables[ %s ].states[ SCREEN_STATE_INDEX ].asset_state, %s );", $_[1]{'num_screen'}, $_[1]{'flag'} ) },
+    RESET_SCREEN_FLAG		=> sub { sprintf( "RESET_SCREEN_FLAG( all_screen_asset_state_tables[ %s ].states[ SCREEN_STATE_INDEX ].asset_state, %s );", $_[1]{'num_screen'}, $_[1]{'flag'} ) },
+    FLOW_VAR_STORE		=> sub { sprintf( "all_flow_vars[ %s ] = %s;", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    FLOW_VAR_INC		=> sub { sprintf( "all_flow_vars[ %s ]++;", $_[1]{'var_id'} ) },
+    FLOW_VAR_ADD		=> sub { sprintf( "all_flow_vars[ %s ] += %s;", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    FLOW_VAR_DEC		=> sub { sprintf( "all_flow_vars[ %s ]--;", $_[1]{'var_id'} ) },
+    FLOW_VAR_SUB		=> sub { sprintf( "all_flow_vars[ %s ] -= %s;", $_[1]{'var_id'}, $_[1]{'value'} ) },
+    HERO_ENABLE_WEAPON		=> sub { "SET_HERO_FLAG( game_state.hero, F_HERO_CAN_SHOOT );" },
+    HERO_DISABLE_WEAPON		=> sub { "RESET_HERO_FLAG( game_state.hero, F_HERO_CAN_SHOOT );" },
+};
+
+# parses a struct initializer like "{ .a = 1, .b = 2 }" into a hash
+sub parse_struct_initializer {
+    my $init = shift;
+    return { map { /^\s*\.(\w+)\s*=\s*(.*?)\s*$/ ? ( $1, $2 ) : () } split( /,/, ( $init =~ /^\s*\{(.*)\}\s*$/ ? $1 : '' ) ) };
+}
+
+# generates the code for a rule table: a function that runs all rules in order
+sub generate_compiled_rule_table_function {
+    my ( $name, $rules ) = @_;
+    my $output = sprintf( "void %s( void ) {\n", $name );
+    $output .= join( "", map { sprintf( "    flow_compiled_rule_%05d();\n", $_ ) } @$rules );
+    $output .= "}\n\n";
+    return $output;
+}
+
+sub generate_compiled_flow_rules {
+    return if not is_build_feature_enabled( 'FLOW_COMPILED_RULES' );
+
+    push @c_game_data_lines, <<FLOW_COMPILED_C_1
+
+///////////////////////////////////////////////////////////
+//
+// Compiled flow rules
+//
+///////////////////////////////////////////////////////////
+
+FLOW_COMPILED_C_1
+;
+
+    # collect the rules that are really used
+    my %used_rules;
+    foreach my $screen ( @all_screens ) {
+        foreach my $table ( @{ $syntax->{'valid_whens'} } ) {
+            $used_rules{ $_ }++ for @{ $screen->{'rules'}{ $table } || [] };
+        }
+    }
+    $used_rules{ $_ }++ for @game_events_rule_table;
+
+    # prototypes for the action functions that are not inlined
+    my %called_actions;
+    foreach my $i ( keys %used_rules ) {
+        foreach my $do ( @{ $all_rules[ $i ]{'do'} } ) {
+            $do =~ m/^(\w+)/;
+            $called_actions{ $1 }++ if not defined( $action_compiled_format->{ $1 } );
+        }
+    }
+    if ( scalar( keys %called_actions ) ) {
+        push @c_game_data_lines, "// action functions from flow.c\n";
+        push @c_game_data_lines, map {
+            sprintf( "void do_rule_action_%s( struct flow_rule_action_s *action ) __z88dk_fastcall;\n", lc( $_ ) )
+        } sort keys %called_actions;
+        push @c_game_data_lines, "\n";
+    }
+
+    # one function for each rule, it can be called from several rule tables
+    foreach my $i ( sort { $a <=> $b } keys %used_rules ) {
+        my $rule = $all_rules[ $i ];
+
+        # action data for the actions that are not inlined - it must be in
+        # the home bank, rules can be run with any dataset mapped
+        if ( grep { m/^(\w+)/; not defined( $action_compiled_format->{ $1 } ) } @{ $rule->{'do'} } ) {
+            push @c_game_data_lines, generate_rule_actions( $rule, $i, 'flow_compiled_actions' );
+        }
+
+        my @checks = map {
+            m/^(\w+)\s*(.*)$/;
+            my ( $check, $check_data ) = ( $1, $2 );
+            '( ' . $check_compiled_format->{ $check }->( $check_data, parse_struct_initializer( $check_data ) ) . ' )';
+        } @{ $rule->{'check'} };
+
+        my $j = 0;
+        my @actions = map {
+            m/^(\w+)\s*(.*)$/;
+            my ( $action, $action_data ) = ( $1, $2 );
+            my $code = ( defined( $action_compiled_format->{ $action } ) ?
+                $action_compiled_format->{ $action }->( $action_data, parse_struct_initializer( $action_data ) ) :
+                sprintf( "do_rule_action_%s( &flow_compiled_actions_%05d[ %d ] );", lc( $action ), $i, $j ) );
+            $j++;
+            $code;
+        } @{ $rule->{'do'} };
+
+        push @c_game_data_lines, sprintf( "static void flow_compiled_rule_%05d( void ) {\n", $i );
+        if ( scalar( @checks ) ) {
+            push @c_game_data_lines, sprintf( "    if ( %s ) {\n", join( " &&\n        ", @checks ) );
+            push @c_game_data_lines, map { "        $_\n" } @actions;
+            push @c_game_data_lines, "    }\n";
+        } else {
+            push @c_game_data_lines, map { "    $_\n" } @actions;
+        }
+        push @c_game_data_lines, "}\n\n";
+    }
+
+    # rule table functions for each screen, and the global screen table
+    my @screen_table_lines;
+    foreach my $screen ( @all_screens ) {
+        my @fields;
+        foreach my $table ( @{ $syntax->{'valid_whens'} } ) {
+            my $rules = $screen->{'rules'}{ $table } || [];
+            if ( scalar( @$rules ) ) {
+                my $function = sprintf( "flow_compiled_screen_%s_%s", $screen->{'name'}, $table );
+                push @c_game_data_lines, generate_compiled_rule_table_function( $function, $rules );
+                push @fields, sprintf( ".%s = %s", $table, $function );
+            } else {
+                push @fields, sprintf( ".%s = NULL", $table );
+            }
+        }
+        push @screen_table_lines, sprintf( "\t{ %s },\t// Screen '%s'\n", join( ', ', @fields ), $screen->{'name'} );
+    }
+    push @c_game_data_lines, generate_compiled_rule_table_function( 'flow_compiled_game_events_rules', \@game_events_rule_table );
+
+    push @c_game_data_lines, "struct flow_compiled_screen_rules_s all_screen_compiled_rules[ MAP_NUM_SCREENS ] = {\n";
+    push @c_game_data_lines, @screen_table_lines;
+    push @c_game_data_lines, "};\n\n";
+}
+
 ###################################
 ## Utility functions
 ###################################
@@ -2603,6 +3373,21 @@ sub pixels_to_byte {
 
 sub check_screen_sprites_are_valid {
     my $errors = 0;
+
+    # pre-shifted sprites are drawn by the SP1 engine, and the bullet sprite
+    # is always created with the standard layout
+    if ( is_build_feature_enabled( 'SPRITE_PRESHIFTED' ) ) {
+        if ( get_sprite_engine() ne 'sp1' ) {
+            warn "SPRITE: PRESHIFT can only be used with the SP1 sprite engine\n";
+            $errors++;
+        }
+        if ( defined( $hero->{'bullet'} ) and
+                $all_sprites[ $sprite_name_to_index{ $hero->{'bullet'}{'sprite'} } ]{'preshift_bits'} ) {
+            warn "SPRITE: PRESHIFT can not be used for the bullet sprite\n";
+            $errors++;
+        }
+    }
+
     my %is_valid_sprite = map { $_->{'name'}, 1 } @all_sprites;
     foreach my $screen ( @all_screens ) {
         foreach my $sprite ( @{ $screen->{'sprites'} } ) {
@@ -2615,6 +3400,26 @@ sub check_screen_sprites_are_valid {
     return $errors;
 }
 
+# maximum number of enemies on a single screen
+sub get_max_enemies_per_screen {
+    my $max = 0;
+    foreach my $screen ( @all_screens ) {
+        my $num_enemies = scalar( @{ $screen->{'enemies'} } );
+        $max = $num_enemies if ( $num_enemies > $max );
+    }
+    return $max;
+}
+
+sub check_screen_enemies_are_valid {
+    my $errors = 0;
+    # the collision grid uses an enemy bitmask of at most 32 bits
+    if ( is_build_feature_enabled( 'COLLISION_GRID' ) and ( get_max_enemies_per_screen > 32 ) ) {
+        warn "COLLISIONS: MODE=GRID can only be used with at most 32 enemies per screen\n";
+        $errors++;
+    }
+    return $errors;
+}
+
 sub check_screen_btiles_are_valid {
     my $errors = 0;
     my %is_valid_btile = map { $_->{'name'}, 1 } @all_btiles;
@@ -2743,6 +3548,122 @@ sub check_game_config_is_valid {
         add_build_feature( 'GAMEAREA_COLOR_FULL' );
     }
 
+    # check screen drawing configuration
+    if ( defined( $game_config->{'screen_draw'} ) ) {
+        if ( not defined( $game_config->{'screen_draw'}{'btiles_per_loop'} ) ) {
+            $game_config->{'screen_draw'}{'btiles_per_loop'} = 8;
+        }
+        if ( not integer_in_range( $game_config->{'screen_draw'}{'btiles_per_loop'}, 1, 255 ) ) {
+            warn "SCREEN_DRAW: BTILES_PER_LOOP must be between 1 and 255\n";
+            $errors++;
+        }
+    }
+
+    # check sprite allocation configuration
+    if ( is_build_feature_enabled( 'SPRITE_POOL' ) and ( get_sprite_engine() ne 'sp1' ) ) {
+        warn "SPRITE_ALLOCATION: MODE=POOL can only be used with the SP1 sprite engine\n";
+        $errors++;
+    }
+
+    # check game loop scheduler configuration
+    if ( defined( $game_config->{'scheduler'}{'budget'} ) and
+            not integer_in_range( $game_config->{'scheduler'}{'budget'}, 1, 255 ) ) {
+        warn "SCHEDULER: BUDGET must be between 1 and 255\n";
+        $errors++;
+    }
+    foreach my $task ( sort keys %{ $game_config->{'tasks'} || {} } ) {
+        my $item = $game_config->{'tasks'}{ $task };
+        foreach my $k ( keys %{ $game_loop_task_defaults{ $task } } ) {
+            if ( not defined( $item->{ $k } ) ) {
+                $item->{ $k } = $game_loop_task_defaults{ $task }{ $k };
+            }
+        }
+        if ( not integer_in_range( $item->{'period'}, 1, 255 ) ) {
+            warn "TASK: $task: PERIOD must be between 1 and 255\n";
+            $errors++;
+        }
+        if ( not integer_in_range( $item->{'phase'}, 0, $item->{'period'} - 1 ) ) {
+            warn "TASK: $task: PHASE must be between 0 and PERIOD-1\n";
+            $errors++;
+        }
+    }
+
+    # check beeper configuration
+    if ( is_build_feature_enabled( 'BEEPER_ISR_FX' ) ) {
+        if ( not defined( $game_config->{'beeper'}{'slice'} ) ) {
+            $game_config->{'beeper'}{'slice'} = 64;
+        }
+        if ( not defined( $game_config->{'beeper'}{'queue'} ) ) {
+            $game_config->{'beeper'}{'queue'} = 4;
+        }
+        if ( not integer_in_range( $game_config->{'beeper'}{'slice'}, 1, 128 ) ) {
+            warn "BEEPER: SLICE must be between 1 and 128\n";
+            $errors++;
+        }
+        if ( not grep { $_ == $game_config->{'beeper'}{'queue'} } ( 2, 4, 8, 16 ) ) {
+            warn "BEEPER: QUEUE must be one of 2, 4, 8, 16\n";
+            $errors++;
+        }
+    }
+    foreach my $sound ( sort keys %{ $game_config->{'sound_priorities'} || {} } ) {
+        if ( not is_build_feature_enabled( 'BEEPER_ISR_FX' ) ) {
+            warn "SOUND_PRIORITY: can only be used with BEEPER MODE=INTERRUPT\n";
+            $errors++;
+            last;
+        }
+        if ( not defined( $game_config->{'sounds'}{ $sound } ) ) {
+            warn sprintf( "SOUND_PRIORITY: sound '%s' is not defined with a SOUND directive\n", uc( $sound ) );
+            $errors++;
+        }
+        if ( not integer_in_range( $game_config->{'sound_priorities'}{ $sound }, 0, 255 ) ) {
+            warn sprintf( "SOUND_PRIORITY: priority for sound '%s' must be between 0 and 255\n", uc( $sound ) );
+            $errors++;
+        }
+    }
+
+    # check dataset cache configuration
+    if ( defined( $game_config->{'dataset_cache'} ) ) {
+        if ( $game_config->{'zx_target'} ne '128' ) {
+            warn "DATASET_CACHE: must be used together with ZX_TARGET = 128\n";
+            $errors++;
+        }
+        if ( not integer_in_range( $game_config->{'dataset_cache'}{'size'}, 1, 4 ) ) {
+            warn "DATASET_CACHE: SIZE must be between 1 and 4\n";
+            $errors++;
+        }
+        if ( defined( $game_config->{'dataset_cache'}{'prefetch'} ) and
+                not integer_in_range( $game_config->{'dataset_cache'}{'prefetch'}, 0, 1024 ) ) {
+            warn "DATASET_CACHE: PREFETCH must be between 0 and 1024\n";
+            $errors++;
+        }
+    }
+
+    # check input record/replay configuration
+    if ( defined( $game_config->{'input_replay'} ) ) {
+        my $replay = $game_config->{'input_replay'};
+        if ( not defined( $replay->{'seed'} ) ) {
+            $replay->{'seed'} = '0x1234';
+        }
+        if ( $replay->{'mode'} eq 'RECORD' ) {
+            if ( $game_config->{'zx_target'} ne '128' ) {
+                warn "INPUT_REPLAY: MODE=RECORD must be used together with ZX_TARGET = 128\n";
+                $errors++;
+            }
+            if ( not defined( $replay->{'bank'} ) ) {
+                $replay->{'bank'} = 6;
+            }
+            if ( not grep { $_ == $replay->{'bank'} } ( 1, 3, 6, 7 ) ) {
+                warn "INPUT_REPLAY: BANK must be one of 1, 3, 6, 7\n";
+                $errors++;
+            }
+        } else {
+            if ( not defined( $replay->{'file'} ) ) {
+                warn "INPUT_REPLAY: MODE=PLAY requires a FILE argument\n";
+                $errors++;
+            }
+        }
+    }
+
     # check SUBs configuration
     my %used_sub_names;
     foreach my $sub ( @{ $game_config->{'single_use_blobs'} } ) {
@@ -2787,11 +3708,135 @@ sub run_consistency_checks {
     $errors += check_game_config_is_valid;
     $errors += check_screen_sprites_are_valid;
     $errors += check_screen_btiles_are_valid;
+    $errors += check_screen_enemies_are_valid;
     $errors += check_screen_items_are_valid;
     die sprintf( "*** %d errors were found in configuration\n", $errors )
         if ( $errors );
 }
 
+# Bouncing enemies that move along a single axis get their limits on that
+# axis clipped against the screen obstacles, so that the engine only needs a
+# compare on each step instead of checking the tile map.  The walk does the
+# same checks as enemy_animate_and_move() in the engine.  On screens with
+# btiles with state the obstacles can change at runtime, so the configured
+# limits are kept in limit_min/limit_max and the engine recalculates the
+# real ones when the screen is entered and when a btile is enabled/disabled
+sub compute_enemy_bounce_limits {
+    my $area = $game_config->{'game_area'};
+
+    foreach my $screen ( @all_screens ) {
+        my @bouncing = grep {
+                ( lc( $_->{'movement'} ) eq 'linear' ) and $_->{'bounce'} and
+                ( ( $_->{'dx'} || 0 ) xor ( $_->{'dy'} || 0 ) )
+            } @{ $screen->{'enemies'} };
+        next if not scalar( @bouncing );
+
+        my $has_dynamic_btiles = grep { "$_->{'asset_state_index'}" ne 'ASSET_NO_STATE' } @{ $screen->{'btiles'} };
+
+        # obstacle map for the btiles without state, which are drawn in
+        # order and clipped to the game area
+        my @obstacle = ( 0 ) x ( 24 * 32 );
+        foreach my $btile ( grep { "$_->{'asset_state_index'}" eq 'ASSET_NO_STATE' } @{ $screen->{'btiles'} } ) {
+            my $bt = $all_btiles[ $btile_name_to_index{ $btile->{'btile'} } ];
+            foreach my $r ( $btile->{'row'} .. ( $btile->{'row'} + $bt->{'rows'} - 1 ) ) {
+                next if ( ( $r < $area->{'top'} ) or ( $r > $area->{'bottom'} ) );
+                foreach my $c ( $btile->{'col'} .. ( $btile->{'col'} + $bt->{'cols'} - 1 ) ) {
+                    next if ( ( $c < $area->{'left'} ) or ( $c > $area->{'right'} ) );
+                    $obstacle[ $r * 32 + $c ] = ( uc( $btile->{'type'} ) eq 'OBSTACLE' ? 1 : 0 );
+                }
+            }
+        }
+        # pixel coordinates are 8 bit values in the engine
+        my $is_obstacle_at = sub {
+            my ( $y, $x ) = @_;
+            return $obstacle[ ( ( $y & 0xff ) >> 3 ) * 32 + ( ( $x & 0xff ) >> 3 ) ] || 0;
+        };
+
+        foreach my $enemy ( @bouncing ) {
+            my $sprite = $all_sprites[ $sprite_name_to_index{ $enemy->{'sprite'} } ];
+            my ( $w, $h ) = ( $sprite->{'cols'} * 8, $sprite->{'rows'} * 8 );
+            my ( $x, $y ) = ( $enemy->{'initx'}, $enemy->{'inity'} );
+            my $horiz = ( $enemy->{'dx'} || 0 );
+            my ( $min_key, $max_key ) = ( $horiz ? ( 'xmin', 'xmax' ) : ( 'ymin', 'ymax' ) );
+
+            if ( $has_dynamic_btiles ) {
+                $enemy->{'limit_min'} = $enemy->{ $min_key };
+                $enemy->{'limit_max'} = $enemy->{ $max_key };
+                $enemy->{'movement_flags'} =~ s/F_ENEMY_MOVE_BOUNCE\b/F_ENEMY_MOVE_BOUNCE_LIMITS/;
+                add_build_feature( 'ENEMY_BOUNCE_LIMITS' );
+                next;
+            }
+
+            my $must_bounce = ( $horiz ?
+                sub { my $p = shift;
+                    $is_obstacle_at->( $y, $p + $w ) or $is_obstacle_at->( $y, $p - 1 ) or
+                    $is_obstacle_at->( $y + $h - 1, $p + $w ) or $is_obstacle_at->( $y + $h - 1, $p - 1 ) } :
+                sub { my $p = shift;
+                    $is_obstacle_at->( $p + $h, $x ) or $is_obstacle_at->( $p - 1, $x ) or
+                    $is_obstacle_at->( $p + $h, $x + $w - 1 ) or $is_obstacle_at->( $p - 1, $x + $w - 1 ) }
+            );
+            # walks from the initial position until the first place where
+            # the enemy would bounce.  Positions are 8 bit values, so the
+            # walk is clamped to 0..255 instead of wrapping around
+            my $walk = sub {
+                my $step = shift;
+                my $p = ( $horiz ? $x : $y );
+                do {
+                    $p += $step;
+                    $p = 0 if ( $p < 0 );
+                    $p = 255 if ( $p > 255 );
+                } while ( ( $p < $enemy->{ $max_key } ) and ( $p > $enemy->{ $min_key } ) and not $must_bounce->( $p ) );
+                return $p;
+            };
+            my $step = abs( $horiz ? $enemy->{'dx'} : $enemy->{'dy'} );
+            ( $enemy->{ $max_key }, $enemy->{ $min_key } ) = ( $walk->( $step ), $walk->( -$step ) );
+            $enemy->{'movement_flags'} =~ s/ \| F_ENEMY_MOVE_BOUNCE\b//;
+        }
+    }
+}
+
+# With animation clocks, animations are grouped by a common clock period:
+# the GCD of their frame and sequence delays.  The delays of each animation
+# are then expressed in clock periods, and the engine only ticks it when its
+# clock fires, which gives exactly the same timing.  Delays of 0 (256) do not
+# scale, and neither do enemies moved in half sets, which are not ticked on
+# every call: those get a clock with period 1
+my @btile_animation_clocks;
+my @enemy_animation_clocks;
+
+sub gcd {
+    my ( $x, $y ) = @_;
+    ( $x, $y ) = ( $y, $x % $y ) while ( $y );
+    return $x;
+}
+
+sub assign_animation_clock {
+    my ( $entity, $clocks, $clock_index, $can_scale ) = @_;
+    my $frame_delay = $entity->{'animation_delay'} || 0;
+    my $sequence_delay = $entity->{'sequence_delay'} || 0;
+    my $period = ( ( $can_scale and $frame_delay and $sequence_delay ) ? gcd( $frame_delay, $sequence_delay ) : 1 );
+    if ( not defined( $clock_index->{ $period } ) ) {
+        $clock_index->{ $period } = scalar( @$clocks );
+        push @$clocks, $period;
+    }
+    $entity->{'animation_clock'} = $clock_index->{ $period };
+    $entity->{'animation_delay'} = $frame_delay / $period;
+    $entity->{'sequence_delay'} = $sequence_delay / $period;
+}
+
+sub compute_animation_clocks {
+    return if not is_build_feature_enabled( 'ANIMATION_CLOCKS' );
+
+    my ( %btile_clock_index, %enemy_clock_index );
+    my $enemies_can_scale = not is_build_feature_enabled( 'ENEMY_MOVE_HALF_SETS' );
+    foreach my $screen ( @all_screens ) {
+        assign_animation_clock( $_, \@btile_animation_clocks, \%btile_clock_index, 1 )
+            for grep { $_->{'is_animated'} } @{ $screen->{'btiles'} };
+        assign_animation_clock( $_, \@enemy_animation_clocks, \%enemy_clock_index, $enemies_can_scale )
+            for @{ $screen->{'enemies'} };
+    }
+}
+
 #############################
 ## General Output Functions
 #############################
@@ -2832,6 +3877,16 @@ sub generate_c_banked_header {
     my $all_flow_rules_ptr	= ( $num_flow_rules ?	'_all_flow_rules'	: '0' );
     my $all_screens_ptr		= ( $num_screens ?	'_all_screens'		: '0' );
 
+    # with btile cell offsets, the dataset asset table also holds the base
+    # of the btile arena, which is shared by all the btiles in the dataset
+    my $btile_arena_extern	= '';
+    my $btile_arena_field	= '';
+    if ( $conditional_build_features{'BTILE_CELL_OFFSETS'} ) {
+        my $btile_arena_ptr	= ( $num_btiles ?	'_all_dataset_btile_data'	: '0' );
+        $btile_arena_extern	= ( $num_btiles ? "extern\t_all_dataset_btile_data\n" : '' );
+        $btile_arena_field	= "    dw\t$btile_arena_ptr\t;; .btile_arena\n";
+    }
+
     if ( $dataset =~ /^\d+$/ ) {
         push @{ $c_dataset_lines->{ $dataset } }, <<EOF_HEADER
 ///////////////////////////////////////////////////////////////////////////
@@ -2878,13 +3933,13 @@ extern	_all_btiles
 extern	_all_sprite_graphics
 extern	_all_flow_rules
 extern	_all_screens
-
+${btile_arena_extern}
 public	_all_assets_dataset_$dataset
 
 _all_assets_dataset_$dataset:
     dw	$num_btiles		;; .num_btiles
     dw	$all_btiles_ptr		;; .all_btiles
-    db	$num_sprites		;; .num_sprite_graphics
+${btile_arena_field}    db	$num_sprites		;; .num_sprite_graphics
     dw	$all_sprites_ptr	;; .all_sprite_graphics
     db	$num_flow_rules		;; .num_flow_rules
     dw	$all_flow_rules_ptr	;; .all_flow_rules
@@ -2927,6 +3982,9 @@ EOF_TILES
 
     my $gamearea_color_full = $conditional_build_features{'GAMEAREA_COLOR_FULL'} || 0;
 
+    my $cell_offsets = $conditional_build_features{'BTILE_CELL_OFFSETS'} || 0;
+    my $cell_offsets_8bit = $conditional_build_features{'BTILE_CELL_OFFSETS_8BIT'} || 0;
+
     # generate the offsets and byte arena for all btiles in the dataset
 
     # the whole dedupe schema works also for animated btiles, since
@@ -2968,21 +4026,47 @@ EOF_TILES
         foreach my $frame ( 0 .. ( $tile->{'frames'} - 1 ) ) {
             my $num_cells = scalar( @{ $tile->{'pixel_bytes'} } ) / $tile->{'frames'};
             my @btile_cell_offsets = @cell_offsets[ $cell_index .. ( $cell_index + $num_cells - 1 ) ];
-            push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t *btile_%s_frame_%d_tiles[ %d ] = {\n\t%s\n};\n",
-                $tile->{'name'},
-                $frame,
-                $num_cells,
-                join( ",\n\t",
-                    map { sprintf( "&all_dataset_btile_data[ %d ]", $_ ) }
-                    @btile_cell_offsets
-                ) );
+            # frame 0 offsets are also needed for pre-rendering screens
+            if ( $frame == 0 ) {
+                $dataset_dependency{ $dataset }{'btile_cell_offsets'}{ $tile->{'name'} } = [ @btile_cell_offsets ];
+            }
+            if ( $cell_offsets ) {
+                # one record per cell: offset bytes (little endian), and
+                # attribute if in full color mode
+                my @frame_attrs = @{ $tile->{'attr'} || $tile->{'png_attr'} }[ ( $frame * $num_cells ) .. ( ( $frame + 1 ) * $num_cells - 1 ) ];
+                my @records = map {
+                    my $i = $_;
+                    my $offset = $btile_cell_offsets[ $i ];
+                    join( ', ',
+                        ( $cell_offsets_8bit ?
+                            sprintf( '0x%02x', $offset ) :
+                            sprintf( '0x%02x, 0x%02x', $offset & 0xff, $offset >> 8 ) ),
+                        ( $gamearea_color_full ? ( $frame_attrs[ $i ] ) : () ),
+                    )
+                } ( 0 .. ( $num_cells - 1 ) );
+                push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t btile_%s_frame_%d_cells[ %d ] = {\n\t%s\n};\n",
+                    $tile->{'name'},
+                    $frame,
+                    $num_cells * ( ( $cell_offsets_8bit ? 1 : 2 ) + ( $gamearea_color_full ? 1 : 0 ) ),
+                    join( ",\n\t", @records ) );
+            } else {
+                push @{ $c_dataset_lines->{ $dataset } }, sprintf( "uint8_t *btile_%s_frame_%d_tiles[ %d ] = {\n\t%s\n};\n",
+                    $tile->{'name'},
+                    $frame,
+                    $num_cells,
+                    join( ",\n\t",
+                        map { sprintf( "&all_dataset_btile_data[ %d ]", $_ ) }
+                        @btile_cell_offsets
+                    ) );
+            }
             $cell_index += $num_cells;
         }
 
         # manually specified attrs have preference over PNG ones
         # warning: this list will be destroyed by splice calls later!
-        # attrs are not output when in monochrome mode
-        if ( $gamearea_color_full ) {
+        # attrs are not output when in monochrome mode, and are already
+        # in the cell records when using cell offsets
+        if ( $gamearea_color_full and not $cell_offsets ) {
             my @attrs = @{ $tile->{'attr'} || $tile->{'png_attr'} };
             foreach my $frame ( 0 .. ( $tile->{'frames'} - 1 ) ) {
                 my @frame_attrs = splice( @attrs, 0, $tile->{'rows'} * $tile->{'cols'} );
@@ -2999,7 +4083,16 @@ EOF_TILES
 
             # output frame table
             # attrs are not output when in monochrome mode
-            if ( $gamearea_color_full ) {
+            if ( $cell_offsets ) {
+                push @{ $c_dataset_lines->{ $dataset } },
+                    sprintf( "struct btile_frame_s btile_%s_frames[ %d ] = {\n\t%s\n};\n\n",
+                        $tile->{'name'},
+                        $tile->{'frames'},
+                        join( ",\n\t", map {
+                                sprintf( "{ .cells = &btile_%s_frame_%d_cells[0] }", $tile->{'name'}, $_ )
+                            } ( 0 .. ( $tile->{'frames'} - 1 ) ) ),
+                    );
+            } elsif ( $gamearea_color_full ) {
                 push @{ $c_dataset_lines->{ $dataset } },
                     sprintf( "struct btile_frame_s btile_%s_frames[ %d ] = {\n\t%s\n};\n\n",
                         $tile->{'name'},
@@ -3108,7 +4201,13 @@ EOF_TILES
             # are short-circuited to frame 0, which always exists
 
             # attrs are not output when in monochrome mode
-            if ( $gamearea_color_full ) {
+            if ( $cell_offsets ) {
+                push @{ $c_dataset_lines->{ $dataset } },
+                    sprintf( "\t{ .num_rows = %d, .num_cols = %d, .cells = &btile_%s_frame_0_cells[0] },\n",
+                        $tile->{'rows'},
+                        $tile->{'cols'},
+                        $tile->{'name'} );
+            } elsif ( $gamearea_color_full ) {
                 push @{ $c_dataset_lines->{ $dataset } },
                     sprintf( "\t{ %d, %d, &btile_%s_frame_0_tiles[0], &btile_%s_frame_0_attrs[0] },\n",
                         $tile->{'rows'},
@@ -3155,11 +4254,14 @@ EOF_SPRITES
     push @{ $c_dataset_lines->{ $dataset } }, "struct sprite_graphic_data_s all_sprite_graphics[ $num_sprites ] = {\n\t";
     push @{ $c_dataset_lines->{ $dataset } }, join( ",\n\n\t", map {
         my $sprite = $_;
-        sprintf( "{ .width = %d, .height = %d,\n\t.frame_data.num_frames = %d,\n\t.frame_data.frames = &sprite_%s_frames[0],\n\t.sequence_data.num_sequences = %d,\n\t.sequence_data.sequences = %s }",
+        sprintf( "{ .width = %d, .height = %d,\n\t.frame_data.num_frames = %d,\n\t.frame_data.frames = &sprite_%s_frames[0],\n\t.sequence_data.num_sequences = %d,\n\t.sequence_data.sequences = %s",
             $_->{'cols'} * 8, $_->{'rows'} * 8,
             $_->{'frames'}, $_->{'name'},
             scalar( @{ $sprite->{'sequences'} } ),	# number of animation sequences
-            ( scalar( @{ $sprite->{'sequences'} } ) ? sprintf( "&sprite_%s_sequences[0]", $_->{'name'}) : 'NULL' ) ),
+            ( scalar( @{ $sprite->{'sequences'} } ) ? sprintf( "&sprite_%s_sequences[0]", $_->{'name'}) : 'NULL' ) ) .
+        ( is_build_feature_enabled( 'SPRITE_PRESHIFTED' ) ?
+            sprintf( ",\n\t.preshift_bits = %d, .preshift_stride = %d }", $sprite->{'preshift_bits'}, $sprite->{'preshift_stride'} || 0 ) :
+            " }" )
     } @dataset_sprites );
     push @{ $c_dataset_lines->{ $dataset } }, "\n};\n\n";
 }
@@ -3195,6 +4297,9 @@ sub generate_map {
 
     my $num_screens = scalar( @dataset_screens );
 
+    # with compiled rules, the screen rule tables are empty
+    my $compiled_rules = is_build_feature_enabled( 'FLOW_COMPILED_RULES' );
+
     # output global map data structure
     push @{ $c_dataset_lines->{ $dataset } }, <<EOF_MAP
 
@@ -3221,6 +4326,22 @@ EOF_MAP
             sprintf( "\t\t.btile_data = { %d, %s },\t// btile_data\n",
                 scalar( @{$_->{'btiles'}} ), ( scalar( @{$_->{'btiles'}} ) ? sprintf( 'screen_%s_btile_pos', $_->{'name'} ) : 'NULL' ) ) .
 
+            # only output if BTILE_PRECOMPILED_TYPE_MAP is used
+            ( is_build_feature_enabled( 'BTILE_PRECOMPILED_TYPE_MAP' ) ?
+                sprintf( "\t\t.tile_type_map = screen_%s_tile_type_map,\t// tile type map\n", $_->{'name'} )
+                : '' ) .
+
+            # only output if MAP_PRERENDERED_SCREENS is used
+            ( is_build_feature_enabled( 'MAP_PRERENDERED_SCREENS' ) ?
+                ( $_->{'static_layer_prerendered'} ?
+                    sprintf( "\t\t.static_layer = { screen_%s_static_grid, %s%s },\t// static_layer\n",
+                        $_->{'name'},
+                        ( $_->{'static_layer_prerendered_tiles'} ? "screen_$_->{name}_static_tiles" : 'NULL' ),
+                        ( is_build_feature_enabled( 'GAMEAREA_COLOR_FULL' ) ?
+                            ( $_->{'static_layer_prerendered_tiles'} ? ", screen_$_->{name}_static_attrs" : ', NULL' ) : '' ) ) :
+                    "\t\t.static_layer = { NULL },\t// static_layer\n" )
+                : '' ) .
+
             # onlye output if ANIMATED_BTILES are used
             ( is_build_feature_enabled( 'ANIMATED_BTILES' ) ?
                 sprintf( "\t\t.animated_btile_data = { %d, %s },\t// btile_data\n",
@@ -3249,8 +4370,8 @@ EOF_MAP
             join( "\n", map {
                 sprintf( "\t\t.flow_data.rule_tables.%s = { %d, %s },",
                     $_,
-                    ( scalar( @{ $screen->{'rules'}{ $_ } } ) || 0 ),
-                    ( scalar( @{ $screen->{'rules'}{ $_ } } ) ?
+                    ( $compiled_rules ? 0 : ( scalar( @{ $screen->{'rules'}{ $_ } } ) || 0 ) ),
+                    ( ( ( not $compiled_rules ) and scalar( @{ $screen->{'rules'}{ $_ } } ) ) ?
                         sprintf( "&screen_%s_%s_rules[0]",
                             $screen_name,
                             $_
@@ -3260,7 +4381,8 @@ EOF_MAP
                 )
                 } @{ $syntax->{'valid_whens'} } ) . "\n" .
 
-            ( defined( $_->{'background'} ) ?
+            # a pre-rendered background is not drawn at runtime
+            ( ( defined( $_->{'background'} ) and not $_->{'background_prerendered'} ) ?
                 sprintf( "\t\t.background_data = { %s, %d, { %d, %d, %d, %d } }\t// background_data\n",
                     sprintf( "BTILE_ID_%s", uc( $_->{'background'}{'btile'} ) ),
                     ( defined( $_->{'background'}{'probability'} ) ? $_->{'background'}{'probability'} : 255 ),
@@ -3334,6 +4456,46 @@ sub generate_game_config {
         }
     }
 
+    # with a sprite pool, all the enemy sprites are created at startup: the
+    # pool has as many sprites of each size as the maximum used by any
+    # screen, and this is what must fit in the heap
+    if ( is_build_feature_enabled( 'SPRITE_POOL' ) ) {
+        my %pool_class_size;
+        foreach my $screen ( @all_screens ) {
+            my %screen_class_size;
+            foreach my $sprite ( map { $all_sprites[ $sprite_name_to_index{ $_->{'sprite'} } ] } @{ $screen->{'enemies'} } ) {
+                $screen_class_size{ sprintf( "%d,%d,%d", $sprite->{'rows'}, $sprite->{'cols'}, ( $sprite->{'preshift_bits'} ? 1 : 0 ) ) }++;
+            }
+            foreach my $class ( keys %screen_class_size ) {
+                if ( ( $pool_class_size{ $class } || 0 ) < $screen_class_size{ $class } ) {
+                    $pool_class_size{ $class } = $screen_class_size{ $class };
+                }
+            }
+        }
+
+        $max_sprites = 0;
+        $max_spritechars = 0;
+        my $first = 0;
+        my @classes = sort keys %pool_class_size;
+        push @c_game_data_lines, "// sprite pool size classes\n";
+        push @c_game_data_lines, "struct sprite_pool_class_s sprite_pool_classes[ SPRITE_POOL_NUM_CLASSES ] = {\n";
+        foreach my $class ( @classes ) {
+            my ( $rows, $cols, $preshifted ) = split( /,/, $class );
+            my $count = $pool_class_size{ $class };
+            push @c_game_data_lines, sprintf( "\t{ .rows = %d, .cols = %d,%s .num_sprites = %d, .first = %d },\n",
+                $rows, $cols,
+                ( is_build_feature_enabled( 'SPRITE_PRESHIFTED' ) ? " .preshifted = $preshifted," : '' ),
+                $count, $first );
+            $first += $count;
+            $max_sprites += $count;
+            $max_spritechars += $count * ( $rows + 1 ) * ( $cols + 1 );
+        }
+        push @c_game_data_lines, "};\n\n";
+        push @h_game_data_lines, "// sprite pool: number of size classes and total sprites\n";
+        push @h_game_data_lines, sprintf( "#define SPRITE_POOL_NUM_CLASSES\t%d\n", scalar( @classes ) );
+        push @h_game_data_lines, sprintf( "#define SPRITE_POOL_SIZE\t%d\n\n", $first );
+    }
+
     # add the hero sprite - just 1
     $max_sprites++;
     my $hs = $all_sprites[ $sprite_name_to_index{ $hero->{'sprite'} } ];
@@ -3389,6 +4551,16 @@ EOF_JSP_POOL
 EOF_BLDCFG1
 ;
 
+    # dataset cache size: number of memory banks reserved for the cache
+    if ( defined( $game_config->{'dataset_cache'} ) ) {
+        push @h_game_data_lines, "// dataset cache slots, one memory bank each\n";
+        push @h_game_data_lines, sprintf( "#define DATASET_CACHE_SIZE\t\t\t%d\n\n", $game_config->{'dataset_cache'}{'size'} );
+        if ( $game_config->{'dataset_cache'}{'prefetch'} ) {
+            push @h_game_data_lines, "// max bytes decompressed by the dataset prefetcher on each game loop\n";
+            push @h_game_data_lines, sprintf( "#define DATASET_PREFETCH_BYTES_PER_STEP\t\t%d\n\n", $game_config->{'dataset_cache'}{'prefetch'} );
+        }
+    }
+
 
     # add CUSTOM_CHARSET definitions of present
     if ( defined( $game_config->{'custom_charset'} ) ) {
@@ -3760,6 +4932,119 @@ sub generate_custom_function_tables {
     }
 }
 
+# dataset prefetch: for each screen, generates the list of the datasets that
+# will most probably be needed after it.  These are the datasets of the
+# destination screens of its WARP_TO_SCREEN actions (which also come from
+# MAPGEN's auto-hotzones), most used first
+sub generate_dataset_prefetch_table {
+    return if not is_build_feature_enabled( 'DATASET_PREFETCH' );
+
+    my $max_candidates = 2;	# must match DATASET_PREFETCH_NUM_CANDIDATES in dataset.h
+
+    push @c_game_data_lines, "//////////////////////////////////////////\n";
+    push @c_game_data_lines, "// DATASET PREFETCH TABLE\n";
+    push @c_game_data_lines, "//////////////////////////////////////////\n\n";
+    push @c_game_data_lines, "uint8_t screen_prefetch_datasets[ MAP_NUM_SCREENS ][ DATASET_PREFETCH_NUM_CANDIDATES ] = {\n";
+
+    foreach my $screen ( @all_screens ) {
+        my %warps_to_dataset;
+        foreach my $table ( keys %{ $screen->{'rules'} || {} } ) {
+            foreach my $rule ( map { $all_rules[ $_ ] } @{ $screen->{'rules'}{ $table } } ) {
+                foreach my $do ( @{ $rule->{'do'} } ) {
+                    # actions have already been compiled at this point
+                    next if ( $do !~ /^WARP_TO_SCREEN\s.*\.num_screen = (\d+)/ );
+                    my $dataset = $all_screens[ $1 ]{'dataset'};
+                    next if ( $dataset eq $screen->{'dataset'} ) or ( $dataset eq 'home' );
+                    $warps_to_dataset{ $dataset }++;
+                }
+            }
+        }
+        my @candidates = sort {
+                ( $warps_to_dataset{ $b } <=> $warps_to_dataset{ $a } ) or ( $a <=> $b )
+            } keys %warps_to_dataset;
+        splice( @candidates, $max_candidates ) if ( scalar( @candidates ) > $max_candidates );
+        push @candidates, 'NO_DATASET' while ( scalar( @candidates ) < $max_candidates );
+        push @c_game_data_lines, sprintf( "\t{ %s },\t// Screen '%s'\n", join( ', ', @candidates ), $screen->{'name'} );
+    }
+
+    push @c_game_data_lines, "};\n\n";
+}
+
+sub generate_beeper_fx_priorities {
+    return if not is_build_feature_enabled( 'BEEPER_ISR_FX' );
+
+    push @c_game_data_lines, "//////////////////////////////////////////\n";
+    push @c_game_data_lines, "// BEEPER FX PRIORITIES\n";
+    push @c_game_data_lines, "//////////////////////////////////////////\n\n";
+    push @c_game_data_lines, "uint8_t beeper_fx_get_priority( void *sfx ) {\n";
+
+    # highest priorities first, so that sounds shared by several events get
+    # the highest one
+    my $priorities = $game_config->{'sound_priorities'} || {};
+    foreach my $sound ( sort { ( $priorities->{ $b } <=> $priorities->{ $a } ) or ( $a cmp $b ) } keys %$priorities ) {
+        next if not $priorities->{ $sound };
+        push @c_game_data_lines, sprintf( "    if ( sfx == SOUND_%s ) return %d;\n", uc( $sound ), $priorities->{ $sound } );
+    }
+    push @c_game_data_lines, "    return 0;\n}\n\n";
+}
+
+sub generate_animation_clocks {
+    return if not is_build_feature_enabled( 'ANIMATION_CLOCKS' );
+
+    push @h_game_data_lines, "// animation clocks\n";
+    push @h_game_data_lines, "extern struct animation_clock_s btile_animation_clocks[];\n";
+    push @h_game_data_lines, "extern struct animation_clock_s enemy_animation_clocks[];\n\n";
+
+    # the clock tables are ended by a clock with period 0
+    push @c_game_data_lines, "// animation clocks\n";
+    foreach my $table ( [ 'btile', \@btile_animation_clocks ], [ 'enemy', \@enemy_animation_clocks ] ) {
+        my ( $name, $clocks ) = @$table;
+        push @c_game_data_lines, sprintf( "struct animation_clock_s %s_animation_clocks[ %d ] = {\n%s\t{ .period = 0 }\n};\n",
+            $name,
+            scalar( @$clocks ) + 1,
+            join( '', map { sprintf( "\t{ .period = %d },\n", $_ ) } @$clocks ),
+        );
+    }
+    push @c_game_data_lines, "\n";
+}
+
+sub generate_input_replay {
+    return if not defined( $game_config->{'input_replay'} );
+    my $replay = $game_config->{'input_replay'};
+
+    push @h_game_data_lines, "// input record/replay\n";
+    push @h_game_data_lines, sprintf( "#define INPUT_REPLAY_SEED\t%s\n", $replay->{'seed'} );
+
+    if ( $replay->{'mode'} eq 'RECORD' ) {
+        # the stream is recorded into a spare memory bank, which must be
+        # excluded from bank assignment (see Makefile-128 and banktool.pl)
+        push @h_game_data_lines, sprintf( "#define INPUT_REPLAY_BANK\t%d\n\n", $replay->{'bank'} );
+        return;
+    }
+
+    # PLAY mode: the RLE stream of ( count, value ) pairs is embedded in the
+    # home bank. It is in the same format that tools/r1replay.pl extracts
+    my @bytes = file_to_bytes( "$build_dir/$replay->{'file'}" );
+    ( scalar( @bytes ) % 2 ) and
+        die "INPUT_REPLAY: $replay->{'file'}: stream size must be even\n";
+    for ( my $i = 0; $i < scalar( @bytes ); $i += 2 ) {
+        $bytes[ $i ] or
+            die "INPUT_REPLAY: $replay->{'file'}: zero count at offset $i\n";
+    }
+
+    push @h_game_data_lines, sprintf( "#define INPUT_REPLAY_DATA_SIZE\t%d\n", scalar( @bytes ) );
+    push @h_game_data_lines, "extern uint8_t input_replay_data[];\n\n";
+
+    push @c_game_data_lines, "//////////////////////////////////////////\n";
+    push @c_game_data_lines, "// INPUT REPLAY DATA\n";
+    push @c_game_data_lines, "//////////////////////////////////////////\n\n";
+    push @c_game_data_lines, sprintf( "uint8_t input_replay_data[ %d ] = {\n", scalar( @bytes ) );
+    my @byte16_groups;	# group in 16-byte-or-less pieces for easier reading/checking
+    push @byte16_groups, [ splice @bytes, 0, 16 ]  while @bytes;
+    push @c_game_data_lines, join( ",\n", map { "\t" . join( ", ", map { sprintf( "0x%02x", $_ ) } @{ $_ } ) } @byte16_groups );
+    push @c_game_data_lines, "\n};\n\n";
+}
+
 sub generate_binary_data_items {
     # return if no binary_data instances
     return if ( not defined( $game_config->{'binary_data'} ) or not scalar( @{ $game_config->{'binary_data'} } ) );
@@ -3931,6 +5216,9 @@ sub generate_tracker_data {
 
 # generates the game_events_rule_table
 sub generate_game_events_rule_table {
+    # with compiled rules, the events table is generated as a function
+    return if is_build_feature_enabled( 'FLOW_COMPILED_RULES' );
+
     # rule checks and actions have been already generated in the home dataset
     # together with the other datasets. We just output the rule pointers here,
     # as it is already done when generating the rules for each screen
@@ -3964,6 +5252,42 @@ sub generate_game_events_rule_table {
 
 sub generate_configuration_values {
 
+    # incremental screen drawing
+    if ( is_build_feature_enabled( 'MAP_INCREMENTAL_DRAW' ) ) {
+        push @h_game_data_lines, "// max btiles drawn on each game loop while switching screens\n";
+        push @h_game_data_lines, sprintf( "#define MAP_DRAW_BTILES_PER_STEP\t%d\n\n",
+            $game_config->{'screen_draw'}{'btiles_per_loop'} );
+    }
+
+    # game loop task scheduling
+    # the frame budget is only defined if configured: by default low
+    # priority tasks are never deferred
+    push @h_game_data_lines, "// game loop scheduler: frame budget and task periods, phases and priorities\n";
+    if ( defined( $game_config->{'scheduler'}{'budget'} ) ) {
+        push @h_game_data_lines, sprintf( "#define GAME_LOOP_FRAME_BUDGET\t%d\n", $game_config->{'scheduler'}{'budget'} );
+    }
+    foreach my $task ( @game_loop_tasks ) {
+        my $item = $game_config->{'tasks'}{ $task } || $game_loop_task_defaults{ $task };
+        push @h_game_data_lines, sprintf( "#define GAME_LOOP_TASK_%s_PERIOD\t%d\n", $task, $item->{'period'} );
+        push @h_game_data_lines, sprintf( "#define GAME_LOOP_TASK_%s_PHASE\t%d\n", $task, $item->{'phase'} );
+        push @h_game_data_lines, sprintf( "#define GAME_LOOP_TASK_%s_PRIORITY\tGAME_LOOP_TASK_PRIORITY_%s\n", $task, $item->{'priority'} );
+    }
+    push @h_game_data_lines, "\n";
+
+    # interrupt driven beeper player
+    if ( is_build_feature_enabled( 'BEEPER_ISR_FX' ) ) {
+        push @h_game_data_lines, "// beeper fx player: loop iterations rendered per interrupt and request queue size\n";
+        push @h_game_data_lines, sprintf( "#define BEEPER_ISR_FX_SLICE\t%d\n", $game_config->{'beeper'}{'slice'} );
+        push @h_game_data_lines, sprintf( "#define BEEPER_FX_QUEUE_SIZE\t%d\n\n", $game_config->{'beeper'}{'queue'} );
+    }
+
+    # max number of enemies in a screen, for the active enemy list and the
+    # collision grid bitmask size
+    if ( is_build_feature_enabled( 'COLLISION_GRID' ) or is_build_feature_enabled( 'ENEMY_ACTIVE_LIST' ) ) {
+        push @h_game_data_lines, "// max enemies on a single screen\n";
+        push @h_game_data_lines, sprintf( "#define MAX_ENEMIES_PER_SCREEN\t%d\n\n", get_max_enemies_per_screen );
+    }
+
     # interrupt configuration values (same for both sprite engines)
     my $int_key = 'interrupts_128';
     push @h_game_data_lines, "// Interrupt configuration\n";
@@ -4016,16 +5340,27 @@ sub generate_game_data {
     generate_game_config and print ".";
     generate_misc_data and print ".";
     generate_game_events_rule_table and print ".";
+    generate_compiled_flow_rules and print ".";
 
     # tracker items
     generate_tracker_data and print ".";
 
+    # beeper fx priorities
+    generate_beeper_fx_priorities and print ".";
+
     # codeset items
     generate_codeset_headers and print ".";
     generate_codeset_functions and print ".";
     generate_global_codeset_data and print ".";
     # binary data items, may be stored in codesets
     generate_binary_data_items and print ".";
+    # input record/replay
+    generate_input_replay and print ".";
+    # animation clocks
+    generate_animation_clocks and print ".";
+
+    # dataset prefetch
+    generate_dataset_prefetch_table and print ".";
 
     # this must be generated after codesets, it needs the codeset function
     # call macros
@@ -4201,9 +5536,12 @@ sub create_dataset_dependencies {
         push @{ $dataset_dependency{ $dataset }{'sprites'} },
             map { $sprite_name_to_index{ $_->{'sprite'} } } @{ $screen->{'enemies'} };
 
-        # add rules
-        push @{ $dataset_dependency{ $dataset }{'rules'} },
-            map { @{ $screen->{'rules'}{ $_ } } } keys %{ $screen->{'rules'} };
+        # add rules - not if they are compiled, they go as code into the
+        # home bank
+        if ( not is_build_feature_enabled( 'FLOW_COMPILED_RULES' ) ) {
+            push @{ $dataset_dependency{ $dataset }{'rules'} },
+                map { @{ $screen->{'rules'}{ $_ } } } keys %{ $screen->{'rules'} };
+        }
     }
 
     # we then add the home dataset dependencies:
@@ -4246,8 +5584,10 @@ sub create_dataset_dependencies {
         $btile_name_to_index{ $hero->{'lives'}{'btile'} };
 
     # add rules in the game events rule table to the home dataset
-    push @{ $dataset_dependency{ 'home' }{'rules'} },
-        @game_events_rule_table;
+    if ( not is_build_feature_enabled( 'FLOW_COMPILED_RULES' ) ) {
+        push @{ $dataset_dependency{ 'home' }{'rules'} },
+            @game_events_rule_table;
+    }
 
     # we must then remove duplicates from the lists
     # we take the oportunity to precalculate some tables
@@ -4308,12 +5648,66 @@ sub fix_feature_dependencies {
         delete $conditional_build_features{ 'BTILE_2BIT_TYPE_MAP' };
     }
 
+    # object slots are encoded in the tile types, which need a full byte.
+    # The slot index has 6 bits
+    if ( defined( $conditional_build_features{ 'BTILE_OBJECT_SLOTS' } ) ) {
+        delete $conditional_build_features{ 'BTILE_2BIT_TYPE_MAP' };
+        foreach my $screen ( @all_screens ) {
+            ( scalar( @{ $screen->{'items'} } ) <= 64 ) and ( scalar( @{ $screen->{'crumbs'} || [] } ) <= 64 ) or
+                die sprintf( "Screen '%s': object slots can only be used with at most 64 items and 64 crumbs per screen\n", $screen->{'name'} );
+        }
+    }
+
     # if ZX_TARGET is 48, CODESETs make no sense
     if ( defined( $conditional_build_features{ 'ZX_TARGET_48' } ) and
         defined( $conditional_build_features{ 'CODESETS' }) ) {
         delete $conditional_build_features{ 'CODESETS' };
     }
 
+    # compiled flow rules do not use dirty masks, and the functions for the
+    # actions that are inlined in the generated code are not needed
+    if ( defined( $conditional_build_features{ 'FLOW_COMPILED_RULES' } ) ) {
+        delete $conditional_build_features{ 'FLOW_DIRTY_MASKS' };
+        foreach my $action ( keys %$action_compiled_format ) {
+            delete $conditional_build_features{ 'FLOW_RULE_ACTION_' . $action };
+        }
+    }
+
+    # no enemies, no active enemy list and no sprite pool
+    if ( get_max_enemies_per_screen == 0 ) {
+        delete $conditional_build_features{ 'ENEMY_ACTIVE_LIST' };
+        delete $conditional_build_features{ 'SPRITE_POOL' };
+    }
+
+    # pre-rendered screens skip drawing the btiles without state, so their
+    # types must come from a precompiled tile type map
+    if ( defined( $conditional_build_features{ 'MAP_PRERENDERED_SCREENS' } ) ) {
+        add_build_feature( 'BTILE_PRECOMPILED_TYPE_MAP' );
+    }
+
+    # btile cell offsets are 8 bit if all the dataset arenas are small
+    # enough even before deduplication (which only makes them smaller)
+    if ( defined( $conditional_build_features{ 'BTILE_CELL_OFFSETS' } ) ) {
+        my $max_arena_size = 0;
+        foreach my $dataset ( keys %dataset_dependency ) {
+            my $arena_size = 0;
+            $arena_size += 8 * scalar( @{ $all_btiles[ $_ ]{'pixel_bytes'} } )
+                for @{ $dataset_dependency{ $dataset }{'btiles'} || [] };
+            $max_arena_size = $arena_size if ( $arena_size > $max_arena_size );
+        }
+        if ( $max_arena_size <= 256 + 7 ) {
+            add_build_feature( 'BTILE_CELL_OFFSETS_8BIT' );
+        }
+    }
+
+    # the hotzone occupancy bitmask has 1 bit for each hotzone in the screen
+    if ( defined( $conditional_build_features{ 'HOTZONE_OCCUPANCY' } ) ) {
+        foreach my $screen ( @all_screens ) {
+            scalar( @{ $screen->{'hotzones'} } ) <= 16 or
+                die sprintf( "Screen '%s': hotzone occupancy can only be used with at most 16 hotzones per screen\n", $screen->{'name'} );
+        }
+    }
+
     # additional fixes here...
 }
 
@@ -4386,6 +5780,12 @@ read_input_data;
 print "Running consistency checks...\n";
 run_consistency_checks;
 
+# precalculate data for the engine
+print "Computing enemy bounce limits...\n";
+compute_enemy_bounce_limits;
+print "Computing animation clocks...\n";
+compute_animation_clocks;
+
 # process data dependencies
 print "Computing dataset dependencies...\n";
 create_dataset_dependencies;
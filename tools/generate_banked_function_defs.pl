@@ -29,6 +29,7 @@ my %features = ( map { $_ => 1 } rage1_build_features_get_all() );
 # file names
 my $asm_table = $cfg->{'build'}{'banked_functions'}{'asm_table_filename'};
 my $c_macros = $cfg->{'build'}{'banked_functions'}{'c_macros_filename'};
+my $c_sections = $cfg->{'build'}{'banked_functions'}{'c_sections_filename'};
 
 # map of signature args to C typecasts
 my %typecast = (
@@ -42,6 +43,31 @@ my @functions = grep {
         $features{ $_->{'build_dependency'} } 
     } @{ $cfg->{'banked_functions'} };
 
+# filter out the banked sections and section members that need to be
+# generated, and add each section as one more banked function.  A section
+# runs several banked functions with a single bank switch
+my %is_plain_function = map { $_->{'name'}, 1 } grep { not defined( $_->{'signature'} ) } @functions;
+my @sections = grep {
+    not defined( $_->{'build_dependency'} ) or
+        $features{ $_->{'build_dependency'} }
+    } @{ $cfg->{'banked_sections'} || [] };
+foreach my $s ( @sections ) {
+    my @members;
+    foreach my $m ( @{ $s->{'functions'} } ) {
+        my ( $f ) = grep { $_->{'name'} eq $m } @{ $cfg->{'banked_functions'} };
+        defined( $f ) or
+            die "Banked section $s->{name}: function $m is not a banked function\n";
+        not defined( $f->{'signature'} ) or
+            die "Banked section $s->{name}: function $m must have no signature\n";
+        # skip members whose build dependency is not enabled
+        push @members, $m if $is_plain_function{ $m };
+    }
+    ( scalar( @members ) <= 16 ) or
+        die "Banked section $s->{name}: a maximum of 16 functions is allowed\n";
+    $s->{'members'} = \@members;
+    push @functions, { 'name' => $s->{'name'}, 'signature' => 'a16' };
+}
+
 #print Dumper( $cfg );
 #print Dumper( \%features );
 
@@ -116,3 +142,36 @@ foreach my $f ( @functions ) {
             $macro, uc( $f->{'name'} );
     }
 }
+
+##
+## Generate C banked code with the banked section functions
+##
+if ( scalar( @sections ) ) {
+    printf CDEF "\n// banked section member flags\n";
+    foreach my $s ( @sections ) {
+        my $bit = 0;
+        print CDEF join( '', map {
+                sprintf( "#define %-50s 0x%04x\n", uc( $s->{'name'} . '_' . $_ ), 1 << $bit++ )
+            } @{ $s->{'members'} } );
+    }
+}
+
+open CSEC, ">$c_sections" or
+    die "Could not open $c_sections for writing\n";
+
+printf CSEC "#include <stdint.h>\n\n";
+printf CSEC "// banked sections: each one runs the member functions selected by the\n";
+printf CSEC "// flags argument, in order, from a single banked call\n\n";
+my %member_done;
+foreach my $m ( map { @{ $_->{'members'} } } @sections ) {
+    next if $member_done{ $m }++;
+    printf CSEC "void %s( void );\n", $m;
+}
+foreach my $s ( @sections ) {
+    printf CSEC "\nvoid %s( uint16_t flags ) {\n", $s->{'name'};
+    my $bit = 0;
+    foreach my $m ( @{ $s->{'members'} } ) {
+        printf CSEC "    if ( flags & 0x%04x ) %s();\n", 1 << $bit++, $m;
+    }
+    printf CSEC "}\n";
+}
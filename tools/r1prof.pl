@@ -0,0 +1,119 @@
+#!/usr/bin/env perl
+################################################################################
+##
+## RAGE1 - Retro Adventure Game Engine, release 1
+## (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+## 
+## This code is published under a GNU GPL license version 3 or later.  See
+## LICENSE file in the distribution for details.
+## 
+################################################################################
+
+# Reads the profiler table from a memory dump or snapshot of a game built
+# with RAGE1_PROFILER=1, and prints a report of the time spent in each
+# phase of the main game loop.  Supported inputs:
+#   - SZX snapshots (.szx)
+#   - SNA snapshots (.sna), 48K or 128K
+#   - Raw memory dumps: 64 KB (from $0000) or 48 KB (from $4000)
+#
+# The table is located with the '_profiler_data' symbol from the map file
+# if one is given, or else by searching for its signature in memory
+
+use strict;
+use warnings;
+use utf8;
+
+use FindBin;
+use lib "$FindBin::Bin/../lib";
+
+require RAGE::SnapshotUtils;
+
+use Getopt::Std;
+
+# phase names, in the order of the PROFILER_PHASE_* constants in profiler.h
+my @phase_names = qw(
+    check_flow_rules
+    move_enemies
+    move_bullets
+    do_hero_actions
+    check_collisions
+    check_game_event_rules
+    check_loop_flags
+    animate_btiles
+    gfx_update
+    LOOP
+);
+
+my $signature = 'R1PF';
+my $ms_per_frame = 20;
+
+our ( $opt_m, $opt_f );
+getopts('m:f:');
+defined( $opt_f ) or
+    die "usage: $0 [-m <map_file>] -f <snapshot_or_dump_file>\n";
+
+# get the profiler table address, from the map file or from the signature
+sub find_profiler_data {
+    my ( $memory, $map_file ) = @_;
+
+    if ( defined( $map_file ) ) {
+        open my $map, "<", $map_file or
+            die "** Error: could not open $map_file for reading\n";
+        while ( my $line = <$map> ) {
+            chomp $line;
+            next if not $line =~ /; addr, public/;
+            if ( $line =~ /^_profiler_data\s+=\s+\$([0-9a-fA-F]+)/ ) {
+                close $map;
+                return hex( '0x' . $1 );
+            }
+        }
+        close $map;
+        die "** Error: symbol _profiler_data not found in $map_file. Was the game built with RAGE1_PROFILER=1?\n";
+    }
+
+    my $address = index( $memory, $signature );
+    ( $address >= 0 ) or
+        die "** Error: profiler data not found in memory. Was the game built with RAGE1_PROFILER=1?\n";
+    return $address;
+}
+
+my $memory = snapshot_memory_image( snapshot_read_ram_pages( $opt_f ) );
+my $address = find_profiler_data( $memory, $opt_m );
+
+( substr( $memory, $address, 4 ) eq $signature ) or
+    die sprintf( "** Error: invalid profiler data signature at \$%04X\n", $address );
+
+my ( $num_phases, $phase_start, $loop_start, $loop_overruns ) =
+    unpack( 'CCCV', substr( $memory, $address + 4, 7 ) );
+( $num_phases == scalar( @phase_names ) ) or
+    die "** Error: unexpected number of phases: $num_phases\n";
+
+my @phases;
+foreach my $i ( 0 .. ( $num_phases - 1 ) ) {
+    my ( $min, $max, $count, $total ) =
+        unpack( 'CCVV', substr( $memory, $address + 11 + 10 * $i, 10 ) );
+    push @phases, { name => $phase_names[ $i ], min => $min, max => $max, count => $count, total => $total };
+}
+my $loop = $phases[ $#phases ];
+
+printf "RAGE1 profiler report - profiler data at \$%04X\n\n", $address;
+printf "%-24s %10s %8s %8s %10s %7s\n", 'Phase', 'Calls', 'Min(ms)', 'Max(ms)', 'Avg(ms)', 'Time%';
+printf "%s\n", '-' x 72;
+foreach my $p ( @phases ) {
+    if ( not $p->{'count'} ) {
+        printf "%-24s %10s\n", $p->{'name'}, 'never run';
+        next;
+    }
+    printf "%-24s %10d %8d %8d %10.3f %6.1f%%\n",
+        $p->{'name'},
+        $p->{'count'},
+        $p->{'min'} * $ms_per_frame,
+        $p->{'max'} * $ms_per_frame,
+        $p->{'total'} * $ms_per_frame / $p->{'count'},
+        ( $loop->{'total'} ? 100 * $p->{'total'} / $loop->{'total'} : 0 );
+}
+printf "%s\n", '-' x 72;
+printf "Frames lost to loop overruns: %d\n", $loop_overruns;
+printf "Total measured time: %.2f s\n", $loop->{'total'} * $ms_per_frame / 1000;
+print "\nNote: times are measured with the 50 Hz frame counter.  Min and max are\n";
+print "quantized to whole frames; averages are statistical estimations.\n";
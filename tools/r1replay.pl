@@ -0,0 +1,74 @@
+#!/usr/bin/env perl
+################################################################################
+##
+## RAGE1 - Retro Adventure Game Engine, release 1
+## (c) Copyright 2020 Jorge Gonzalez Villalonga <jorgegv@daikon.es>
+## 
+## This code is published under a GNU GPL license version 3 or later.  See
+## LICENSE file in the distribution for details.
+## 
+################################################################################
+
+# Extracts the controller input recorded by a game built with INPUT_REPLAY
+# MODE=RECORD from a snapshot (SZX or 128K SNA) or a raw 16 KB dump of the
+# recording memory bank, and writes it to a file that can be used with
+# INPUT_REPLAY MODE=PLAY.  With -d, it also dumps the stream contents.
+#
+# Recording bank format: a 16-bit length, followed by the RLE stream:
+# (count,value) byte pairs, one controller state value repeated count
+# times.  The output file is just the RLE stream
+
+use strict;
+use warnings;
+use utf8;
+
+use FindBin;
+use lib "$FindBin::Bin/../lib";
+
+require RAGE::SnapshotUtils;
+
+use Getopt::Std;
+
+our ( $opt_f, $opt_b, $opt_o, $opt_d );
+getopts('f:b:o:d');
+( defined( $opt_f ) and ( defined( $opt_o ) or defined( $opt_d ) ) ) or
+    die "usage: $0 -f <snapshot_or_bank_dump> [-b <bank>] [-o <output_file>] [-d]\n";
+
+# get the recording bank data
+my $bank_data;
+if ( -s $opt_f == 0x4000 ) {
+    open my $fh, "<:raw", $opt_f or
+        die "** Error: could not open $opt_f for reading\n";
+    $bank_data = do { local $/; <$fh> };
+    close $fh;
+} else {
+    defined( $opt_b ) or
+        die "** Error: the recording bank (-b) must be specified for snapshots\n";
+    my $pages = snapshot_read_ram_pages( $opt_f );
+    defined( $pages->{ $opt_b } ) or
+        die "** Error: memory bank $opt_b not found in $opt_f\n";
+    $bank_data = $pages->{ $opt_b };
+}
+
+my $length = unpack( 'v', substr( $bank_data, 0, 2 ) );
+( ( $length % 2 ) == 0 ) and ( $length <= 0x4000 - 2 ) or
+    die "** Error: invalid recorded stream length: $length\n";
+my $stream = substr( $bank_data, 2, $length );
+
+if ( $opt_d ) {
+    my ( $iterations, $pairs ) = ( 0, 0 );
+    foreach my $pair ( unpack( '(a2)*', $stream ) ) {
+        my ( $count, $value ) = unpack( 'CC', $pair );
+        printf "%5d x 0x%02x\n", $count, $value;
+        $iterations += $count;
+        $pairs++;
+    }
+    printf "%d RLE pairs, %d game loop iterations\n", $pairs, $iterations;
+}
+
+if ( defined( $opt_o ) ) {
+    open my $out, ">:raw", $opt_o or
+        die "** Error: could not open $opt_o for writing\n";
+    print $out $stream;
+    close $out;
+}
@@ -16,10 +16,11 @@ use utf8;
 use Getopt::Std;
 use Data::Dumper;
 
-our ( $opt_m );
-getopts('m:');
+# -s: strict mode, fail if a symbol is not found in the map file
+our ( $opt_m, $opt_s );
+getopts('m:s');
 defined( $opt_m ) or
-    die "usage: $0 -m <map_file>\n";
+    die "usage: $0 -m <map_file> [-s]\n";
 my $map_file = $opt_m;
 
 my $address;
@@ -41,8 +42,10 @@ while ( my $line = <STDIN> ) {
     chomp $line;
     $line =~ s/#.*$//g;		# remove comments
     next if $line =~ /^$/;	# skip blank lines
-    while ( $line =~ /\{([\w_\+\-\$xX]+)\}/ ) {
-        my $expr = $1;
+    while ( $line =~ /\{(\??)([\w_\+\-\$xX]+)\}/ ) {
+        # {?<symbol>}: optional symbol, it is replaced by 0 if not found
+        # even in strict mode
+        my ( $optional, $expr ) = ( $1, $2 );
 
         my $sym;
         my $offset = 0;
@@ -67,9 +70,12 @@ while ( my $line = <STDIN> ) {
         } else {
             die "** Invalid syntax: '$expr'\n";
         }
-        my $addr = $address->{ $sym } + $offset;
+        if ( $opt_s and not $optional and not defined( $address->{ $sym } ) ) {
+            die "** Error: symbol '$sym' not found in $map_file\n";
+        }
+        my $addr = ( $address->{ $sym } || 0 ) + $offset;
         my $hex_addr = sprintf( "%04x", $addr );
-        $line =~ s/\{\Q$expr\E\}/\$\Q$hex_addr\E/g;
+        $line =~ s/\{\Q$optional$expr\E\}/\$\Q$hex_addr\E/g;
     }
     print $line,"\n";
 }